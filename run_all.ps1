@@ -100,9 +100,22 @@ Write-Host "Compilando C..."
 gcc -std=c11 -Wall -Wextra src\matriz_c.c -o $CExe -lm
 gcc -std=c11 -Wall -Wextra src\matriz_c.c -o $CO3Exe -lm -O3
 
+$LibObj = Join-Path $BuildWin "matbench.o"
+$LibO3Obj = Join-Path $BuildWin "matbench_O3.o"
+$LibStatic = Join-Path $BuildWin "libmatbench.a"
+$LibDll = Join-Path $BuildWin "matbench.dll"
+
+# O kernel blas (-DMATRIZ_BLAS) so e compilado pelo run_all.sh, quando ele
+# encontra OpenBLAS ou BLIS; aqui a biblioteca sai sem ele.
+Write-Host "Compilando libmatbench..."
+g++ -std=c++17 -Wall -Wextra -pthread -c src\matbench.cpp -o $LibObj
+g++ -std=c++17 -Wall -Wextra -pthread -c src\matbench.cpp -o $LibO3Obj -O3
+ar rcs $LibStatic $LibO3Obj
+g++ -shared -pthread $LibO3Obj -o $LibDll
+
 Write-Host "Compilando C++..."
-g++ -std=c++17 -Wall -Wextra src\matriz_cpp.cpp -o $CppExe
-g++ -std=c++17 -Wall -Wextra src\matriz_cpp.cpp -o $CppO3Exe -O3
+g++ -std=c++17 -Wall -Wextra -pthread src\matriz_cpp.cpp $LibObj -o $CppExe
+g++ -std=c++17 -Wall -Wextra -pthread src\matriz_cpp.cpp $LibStatic -o $CppO3Exe -O3
 
 Write-Host "Compilando Java..."
 javac -d $BuildJava src\matriz_java.java
@@ -117,7 +130,66 @@ Write-Host "Executando C++..."
 & $CppExe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp.csv")
 
 Write-Host "Executando C++ -O3..."
-& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_O3.csv")
+# --mem-stats (RSS e faltas de pagina por fase) so existe no Linux; o run_all.sh o usa aqui e no Strassen.
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_O3.csv") --perf-stats (Join-Path $OutDir "resultado_cpp_O3_perf.csv") --samples (Join-Path $OutDir "resultado_cpp_O3_amostras.csv") --roofline (Join-Path $OutDir "resultado_cpp_O3.roofline.json")
+
+# O cache do autotuner (build\matriz_cpp_tune.json) e lido automaticamente pelas
+# execucoes abaixo; apague-o para reajustar os kernels nesta maquina.
+$TuneCache = Join-Path "build" "matriz_cpp_tune.json"
+if (-not (Test-Path $TuneCache)) {
+    foreach ($Kernel in @("blocked", "simd")) {
+        Write-Host "Ajustando parametros do C++ -O3 (kernel $Kernel)..."
+        & $CppO3Exe 1024 3 2 0 (Join-Path $OutDir "resultado_cpp_tune_${Kernel}_O3.csv") --kernel $Kernel --tune
+    }
+}
+
+Write-Host "Executando C++ -O3 (kernel blocked)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_blocked_O3.csv") --kernel blocked --perf-stats (Join-Path $OutDir "resultado_cpp_blocked_O3_perf.csv") --samples (Join-Path $OutDir "resultado_cpp_blocked_O3_amostras.csv") --ci-target 0.02 --time-cap 30 --roofline (Join-Path $OutDir "resultado_cpp_blocked_O3.roofline.json") --meta-json (Join-Path $OutDir "resultado_cpp_blocked_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (kernel simd)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_simd_O3.csv") --kernel simd --meta-json (Join-Path $OutDir "resultado_cpp_simd_O3.meta.json") --roofline (Join-Path $OutDir "resultado_cpp_simd_O3.roofline.json")
+
+foreach ($DType in @("int64", "float", "double")) {
+    Write-Host "Executando C++ -O3 (kernel simd, $DType)..."
+    & $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_simd_${DType}_O3.csv") --kernel simd --dtype $DType --meta-json (Join-Path $OutDir "resultado_cpp_simd_${DType}_O3.meta.json")
+}
+
+Write-Host "Executando C++ -O3 (kernel simd, entradas aleatorias)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_simd_random_O3.csv") --kernel simd --input random --seed 42 --meta-json (Join-Path $OutDir "resultado_cpp_simd_random_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (kernel strassen)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_strassen_O3.csv") --kernel strassen --meta-json (Join-Path $OutDir "resultado_cpp_strassen_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (kernel morton)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_morton_O3.csv") --kernel morton --meta-json (Join-Path $OutDir "resultado_cpp_morton_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (kernel packed)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_packed_O3.csv") --kernel packed --meta-json (Join-Path $OutDir "resultado_cpp_packed_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (varredura intercalada de kernels)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_sweep_O3.csv") --sweep naive,blocked,simd,strassen,morton,packed --results-json (Join-Path $OutDir "resultado_cpp_sweep_O3.json") --meta-json (Join-Path $OutDir "resultado_cpp_sweep_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (GEMM geral: formas e transposicoes)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_gemm_O3.csv") --gemm square,tall,wide,inner,outer --trans nn,nt,tn,tt --dtype double --beta 1 --ld-pad 8 --meta-json (Join-Path $OutDir "resultado_cpp_gemm_O3.meta.json")
+
+foreach ($Alloc in @("arena", "hugepage")) {
+    Write-Host "Executando C++ -O3 (alocacao $Alloc)..."
+    & $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_${Alloc}_O3.csv") --alloc $Alloc --meta-json (Join-Path $OutDir "resultado_cpp_${Alloc}_O3.meta.json")
+}
+
+Write-Host "Executando C++ -O3 (esparso CSR vs denso)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_sparse_O3.csv") --kernel simd --sparse 0.001,0.01,0.05,0.2,0.5 --meta-json (Join-Path $OutDir "resultado_cpp_sparse_O3.meta.json")
+
+# O motor fora do nucleo (--ooc, resultado_cpp_ooc_O3.csv) usa mmap e so roda no Linux (run_all.sh).
+# O modo distribuido (--distributed, resultado_cpp_{summa,cannon}_O3.csv) usa fork e tambem so roda no Linux.
+Write-Host "Executando C++ -O3 (lote de matrizes pequenas)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_batch_O3.csv") --batch 10000 --meta-json (Join-Path $OutDir "resultado_cpp_batch_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (escalonamento por threads)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_scaling_O3.csv") --kernel blocked --threads-sweep --sched-stats (Join-Path $OutDir "resultado_cpp_scaling_O3_threads.csv") --meta-json (Join-Path $OutDir "resultado_cpp_scaling_O3.meta.json")
+
+Write-Host "Executando C++ -O3 (roubo de tarefas, todas as CPUs)..."
+& $CppO3Exe $B $Npts $M $Escala (Join-Path $OutDir "resultado_cpp_steal_O3.csv") --kernel blocked --threads 0 --schedule steal --sched-stats (Join-Path $OutDir "resultado_cpp_steal_O3_threads.csv") --verify freivalds --init parallel --meta-json (Join-Path $OutDir "resultado_cpp_steal_O3.meta.json")
 
 Write-Host "Executando Java..."
 java -cp $BuildJava matriz_java $B $Npts $M $Escala (Join-Path $OutDir "resultado_java.csv")
@@ -171,6 +243,11 @@ $sysInfo = [ordered]@{
         }
     }
 }
+# Tetos do roofline medidos pelo C++ (banda STREAM e pico de computacao).
+$RooflineJson = Join-Path $OutDir "resultado_cpp_O3.roofline.json"
+if (Test-Path $RooflineJson) {
+    $sysInfo["roofline"] = Get-Content -Raw $RooflineJson | ConvertFrom-Json
+}
 $sysInfo | ConvertTo-Json -Depth 8 | Set-Content -Encoding utf8 $SysJson
 
 $Manifest = [ordered]@{
@@ -198,12 +275,37 @@ $Manifest = [ordered]@{
     languages = @(
         [ordered]@{ name = "C"; flags = "-std=c11 -Wall -Wextra"; output = "resultado_c.csv" },
         [ordered]@{ name = "C"; flags = "-std=c11 -Wall -Wextra -O3"; output = "resultado_c_O3.csv" },
-        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra"; output = "resultado_cpp.csv" },
-        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -O3"; output = "resultado_cpp_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread"; output = "resultado_cpp.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; output = "resultado_cpp_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "blocked"; output = "resultado_cpp_blocked_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "simd"; output = "resultado_cpp_simd_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "simd"; dtype = "int64"; output = "resultado_cpp_simd_int64_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "simd"; dtype = "float"; output = "resultado_cpp_simd_float_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "simd"; dtype = "double"; output = "resultado_cpp_simd_double_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "simd"; input = "random"; output = "resultado_cpp_simd_random_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "strassen"; output = "resultado_cpp_strassen_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "morton"; output = "resultado_cpp_morton_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "packed"; output = "resultado_cpp_packed_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; mode = "sweep"; kernels = "naive,blocked,simd,strassen,morton,packed"; output = "resultado_cpp_sweep_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; mode = "gemm"; shapes = "square,tall,wide,inner,outer"; trans = "nn,nt,tn,tt"; dtype = "double"; output = "resultado_cpp_gemm_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "blocked"; mode = "threads-sweep"; output = "resultado_cpp_scaling_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; alloc = "arena"; output = "resultado_cpp_arena_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; alloc = "hugepage"; output = "resultado_cpp_hugepage_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; mode = "batch"; output = "resultado_cpp_batch_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "simd"; mode = "sparse"; output = "resultado_cpp_sparse_O3.csv" },
+        [ordered]@{ name = "C++"; flags = "-std=c++17 -Wall -Wextra -pthread -O3"; kernel = "blocked"; schedule = "steal"; init = "parallel"; output = "resultado_cpp_steal_O3.csv" },
         [ordered]@{ name = "Java"; flags = ""; output = "resultado_java.csv" },
         [ordered]@{ name = "Python"; flags = ""; output = "resultado_python.csv" }
     )
 }
+# Metadados gravados pelo proprio benchmark (--meta-json), como o ISA escolhido.
+foreach ($Language in $Manifest.languages) {
+    $MetaPath = Join-Path $OutDir ($Language.output -replace '\.csv$', '.meta.json')
+    if (Test-Path $MetaPath) {
+        $Language["meta"] = Get-Content -Raw $MetaPath | ConvertFrom-Json
+        $Language["isa"] = $Language["meta"].isa
+    }
+}
 $Manifest | ConvertTo-Json -Depth 8 | Set-Content -Encoding utf8 (Join-Path $OutDir "run_manifest.json")
 
 Write-Host "Gerando graficos..."
@@ -140,9 +140,41 @@ echo "Compilando C..."
 gcc -std=c11 -Wall -Wextra src/matriz_c.c -o "$BUILD_LINUX/matriz_c" -lm
 gcc -std=c11 -Wall -Wextra src/matriz_c.c -o "$BUILD_LINUX/matriz_c_O3" -lm -O3
 
+# Kernel blas: usa a primeira CBLAS instalada (OpenBLAS, depois BLIS) que
+# compila e liga um cblas_dgemm; sem nenhuma, o kernel fica de fora.
+BLAS_LIB=""
+BLAS_CFLAGS=()
+BLAS_LIBS=()
+for CANDIDATE in openblas blis; do
+  INCLUDE=()
+  [ "$CANDIDATE" = "blis" ] && INCLUDE=(-I/usr/include/blis)
+  if printf '#include <cblas.h>\nint main(void){double x=1;cblas_dgemm(CblasRowMajor,CblasNoTrans,CblasNoTrans,1,1,1,1.0,&x,1,&x,1,0.0,&x,1);return 0;}\n' \
+    | gcc -x c - "${INCLUDE[@]}" -o "$BUILD_LINUX/blas_probe" "-l$CANDIDATE" >/dev/null 2>&1; then
+    BLAS_LIB="$CANDIDATE"
+    BLAS_CFLAGS=(-DMATRIZ_BLAS "${INCLUDE[@]}")
+    BLAS_LIBS=("-l$CANDIDATE")
+    break
+  fi
+done
+rm -f "$BUILD_LINUX/blas_probe"
+if [ -n "$BLAS_LIB" ]; then
+  echo "BLAS encontrado: $BLAS_LIB (kernel blas habilitado)"
+else
+  echo "BLAS (OpenBLAS ou BLIS) nao encontrado; kernel blas ignorado"
+fi
+
+echo "Compilando libmatbench..."
+g++ -std=c++17 -Wall -Wextra -pthread -fPIC "${BLAS_CFLAGS[@]}" -c src/matbench.cpp -o "$BUILD_LINUX/matbench.o"
+g++ -std=c++17 -Wall -Wextra -pthread -fPIC "${BLAS_CFLAGS[@]}" -c src/matbench.cpp -o "$BUILD_LINUX/matbench_O3.o" -O3
+rm -f "$BUILD_LINUX/libmatbench.a"
+ar rcs "$BUILD_LINUX/libmatbench.a" "$BUILD_LINUX/matbench_O3.o"
+g++ -shared -pthread "$BUILD_LINUX/matbench_O3.o" -o "$BUILD_LINUX/libmatbench.so" "${BLAS_LIBS[@]}"
+
 echo "Compilando C++..."
-g++ -std=c++17 -Wall -Wextra src/matriz_cpp.cpp -o "$BUILD_LINUX/matriz_cpp"
-g++ -std=c++17 -Wall -Wextra src/matriz_cpp.cpp -o "$BUILD_LINUX/matriz_cpp_O3" -O3
+g++ -std=c++17 -Wall -Wextra -pthread "${BLAS_CFLAGS[@]}" src/matriz_cpp.cpp "$BUILD_LINUX/matbench.o" -o "$BUILD_LINUX/matriz_cpp" \
+  "${BLAS_LIBS[@]}"
+g++ -std=c++17 -Wall -Wextra -pthread "${BLAS_CFLAGS[@]}" src/matriz_cpp.cpp "$BUILD_LINUX/libmatbench.a" -o "$BUILD_LINUX/matriz_cpp_O3" -O3 \
+  "${BLAS_LIBS[@]}"
 
 echo "Compilando Java..."
 javac -d "$BUILD_JAVA" src/matriz_java.java
@@ -157,7 +189,105 @@ echo "Executando C++..."
 "$BUILD_LINUX/matriz_cpp" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp.csv"
 
 echo "Executando C++ -O3..."
-"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_O3.csv"
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_O3.csv" \
+  --perf-stats "$OUT_DIR/resultado_cpp_O3_perf.csv" --samples "$OUT_DIR/resultado_cpp_O3_amostras.csv" \
+  --roofline "$OUT_DIR/resultado_cpp_O3.roofline.json" --mem-stats
+
+# O cache do autotuner (build/matriz_cpp_tune.json) e lido automaticamente pelas
+# execucoes abaixo; apague-o para reajustar os kernels nesta maquina.
+if [[ ! -f build/matriz_cpp_tune.json ]]; then
+  for KERNEL in blocked simd; do
+    echo "Ajustando parametros do C++ -O3 (kernel $KERNEL)..."
+    "$BUILD_LINUX/matriz_cpp_O3" 1024 3 2 0 "$OUT_DIR/resultado_cpp_tune_${KERNEL}_O3.csv" --kernel "$KERNEL" --tune
+  done
+fi
+
+echo "Executando C++ -O3 (kernel blocked)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_blocked_O3.csv" --kernel blocked \
+  --perf-stats "$OUT_DIR/resultado_cpp_blocked_O3_perf.csv" --samples "$OUT_DIR/resultado_cpp_blocked_O3_amostras.csv" \
+  --ci-target 0.02 --time-cap 30 --roofline "$OUT_DIR/resultado_cpp_blocked_O3.roofline.json" \
+  --meta-json "$OUT_DIR/resultado_cpp_blocked_O3.meta.json"
+
+echo "Executando C++ -O3 (kernel simd)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_simd_O3.csv" \
+  --kernel simd --meta-json "$OUT_DIR/resultado_cpp_simd_O3.meta.json" \
+  --roofline "$OUT_DIR/resultado_cpp_simd_O3.roofline.json"
+
+for DTYPE in int64 float double; do
+  echo "Executando C++ -O3 (kernel simd, $DTYPE)..."
+  "$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_simd_${DTYPE}_O3.csv" \
+    --kernel simd --dtype "$DTYPE" --meta-json "$OUT_DIR/resultado_cpp_simd_${DTYPE}_O3.meta.json"
+done
+
+echo "Executando C++ -O3 (kernel simd, entradas aleatorias)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_simd_random_O3.csv" \
+  --kernel simd --input random --seed 42 --meta-json "$OUT_DIR/resultado_cpp_simd_random_O3.meta.json"
+
+echo "Executando C++ -O3 (kernel strassen)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_strassen_O3.csv" \
+  --kernel strassen --mem-stats --meta-json "$OUT_DIR/resultado_cpp_strassen_O3.meta.json"
+
+echo "Executando C++ -O3 (kernel morton)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_morton_O3.csv" \
+  --kernel morton --meta-json "$OUT_DIR/resultado_cpp_morton_O3.meta.json"
+
+echo "Executando C++ -O3 (kernel packed)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_packed_O3.csv" \
+  --kernel packed --meta-json "$OUT_DIR/resultado_cpp_packed_O3.meta.json"
+
+echo "Executando C++ -O3 (varredura intercalada de kernels)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_sweep_O3.csv" \
+  --sweep naive,blocked,simd,strassen,morton,packed --results-json "$OUT_DIR/resultado_cpp_sweep_O3.json" \
+  --meta-json "$OUT_DIR/resultado_cpp_sweep_O3.meta.json"
+
+echo "Executando C++ -O3 (GEMM geral: formas e transposicoes)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_gemm_O3.csv" \
+  --gemm square,tall,wide,inner,outer --trans nn,nt,tn,tt --dtype double --beta 1 --ld-pad 8 \
+  --meta-json "$OUT_DIR/resultado_cpp_gemm_O3.meta.json"
+
+for ALLOC in arena hugepage; do
+  echo "Executando C++ -O3 (alocacao $ALLOC)..."
+  "$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_${ALLOC}_O3.csv" \
+    --alloc "$ALLOC" --meta-json "$OUT_DIR/resultado_cpp_${ALLOC}_O3.meta.json"
+done
+
+echo "Executando C++ -O3 (esparso CSR vs denso)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_sparse_O3.csv" \
+  --kernel simd --sparse 0.001,0.01,0.05,0.2,0.5 --meta-json "$OUT_DIR/resultado_cpp_sparse_O3.meta.json"
+
+echo "Executando C++ -O3 (fora do nucleo, arquivos mapeados)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_ooc_O3.csv" \
+  --ooc "$OUT_DIR" --ooc-mem 64 --meta-json "$OUT_DIR/resultado_cpp_ooc_O3.meta.json"
+
+for ALGORITHM in summa cannon; do
+  echo "Executando C++ -O3 (distribuido $ALGORITHM, 4 processos)..."
+  "$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_${ALGORITHM}_O3.csv" \
+    --distributed 4 --dist-algorithm "$ALGORITHM" --meta-json "$OUT_DIR/resultado_cpp_${ALGORITHM}_O3.meta.json"
+done
+
+echo "Executando C++ -O3 (lote de matrizes pequenas)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_batch_O3.csv" \
+  --batch 10000 --meta-json "$OUT_DIR/resultado_cpp_batch_O3.meta.json"
+
+echo "Executando C++ -O3 (escalonamento por threads)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_scaling_O3.csv" \
+  --kernel blocked --threads-sweep --sched-stats "$OUT_DIR/resultado_cpp_scaling_O3_threads.csv" \
+  --meta-json "$OUT_DIR/resultado_cpp_scaling_O3.meta.json"
+
+if [ -n "$BLAS_LIB" ]; then
+  echo "Executando C++ -O3 (kernel blas com $BLAS_LIB)..."
+  "$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_blas_O3.csv" \
+    --kernel blas --dtype double --meta-json "$OUT_DIR/resultado_cpp_blas_O3.meta.json"
+
+  echo "Executando C++ -O3 (escalonamento do kernel blas)..."
+  "$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_blas_scaling_O3.csv" \
+    --kernel blas --dtype double --threads-sweep --meta-json "$OUT_DIR/resultado_cpp_blas_scaling_O3.meta.json"
+fi
+
+echo "Executando C++ -O3 (roubo de tarefas, todas as CPUs)..."
+"$BUILD_LINUX/matriz_cpp_O3" "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_cpp_steal_O3.csv" \
+  --kernel blocked --threads 0 --schedule steal --sched-stats "$OUT_DIR/resultado_cpp_steal_O3_threads.csv" \
+  --verify freivalds --init parallel --pin compact --meta-json "$OUT_DIR/resultado_cpp_steal_O3.meta.json"
 
 echo "Executando Java..."
 java -cp "$BUILD_JAVA" matriz_java "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resultado_java.csv"
@@ -168,12 +298,30 @@ python3 src/matriz_python.py "$B" "$NPTS" "$M_COUNT" "$ESCALA" "$OUT_DIR/resulta
 echo "Capturando informacoes de sistema..."
 bash scripts/gen_sysinfo_md.sh "$OUT_DIR/system_info.md" "$OUT_DIR/system_info.json"
 
+# Tetos do roofline medidos pelo C++ (banda STREAM e pico de computacao).
+ROOFLINE_JSON="$OUT_DIR/resultado_cpp_O3.roofline.json" SYSINFO_JSON="$OUT_DIR/system_info.json" python3 - <<'PY'
+import json
+import os
+
+roofline_path = os.environ["ROOFLINE_JSON"]
+if os.path.exists(roofline_path):
+    with open(roofline_path, encoding="utf-8") as f:
+        roofline = json.load(f)
+    with open(os.environ["SYSINFO_JSON"], encoding="utf-8") as f:
+        info = json.load(f)
+    info["roofline"] = roofline
+    with open(os.environ["SYSINFO_JSON"], "w", encoding="utf-8") as f:
+        json.dump(info, f, ensure_ascii=False, indent=2)
+        f.write("\n")
+PY
+
 export RUN_ID="$RUN_NAME"
 export PARAM_B="$B"
 export PARAM_NPTS="$NPTS"
 export PARAM_M="$M_COUNT"
 export PARAM_ESCALA="$ESCALA"
 export MANIFEST_PATH="$OUT_DIR/run_manifest.json"
+export BLAS_LIB
 
 python3 - <<'PY'
 import json
@@ -213,13 +361,50 @@ data = {
     "languages": [
         {"name": "C", "flags": "-std=c11 -Wall -Wextra", "output": "resultado_c.csv"},
         {"name": "C", "flags": "-std=c11 -Wall -Wextra -O3", "output": "resultado_c_O3.csv"},
-        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra", "output": "resultado_cpp.csv"},
-        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -O3", "output": "resultado_cpp_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread", "output": "resultado_cpp.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "output": "resultado_cpp_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "blocked", "output": "resultado_cpp_blocked_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "simd", "output": "resultado_cpp_simd_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "simd", "dtype": "int64", "output": "resultado_cpp_simd_int64_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "simd", "dtype": "float", "output": "resultado_cpp_simd_float_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "simd", "dtype": "double", "output": "resultado_cpp_simd_double_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "simd", "input": "random", "output": "resultado_cpp_simd_random_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "strassen", "output": "resultado_cpp_strassen_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "morton", "output": "resultado_cpp_morton_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "packed", "output": "resultado_cpp_packed_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "mode": "sweep", "kernels": "naive,blocked,simd,strassen,morton,packed", "output": "resultado_cpp_sweep_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "mode": "gemm", "shapes": "square,tall,wide,inner,outer", "trans": "nn,nt,tn,tt", "dtype": "double", "output": "resultado_cpp_gemm_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "blocked", "mode": "threads-sweep", "output": "resultado_cpp_scaling_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "alloc": "arena", "output": "resultado_cpp_arena_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "alloc": "hugepage", "output": "resultado_cpp_hugepage_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "mode": "batch", "output": "resultado_cpp_batch_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "mode": "ooc", "output": "resultado_cpp_ooc_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "simd", "mode": "sparse", "output": "resultado_cpp_sparse_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "mode": "distributed", "algorithm": "summa", "output": "resultado_cpp_summa_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "mode": "distributed", "algorithm": "cannon", "output": "resultado_cpp_cannon_O3.csv"},
+        {"name": "C++", "flags": "-std=c++17 -Wall -Wextra -pthread -O3", "kernel": "blocked", "schedule": "steal", "init": "parallel", "pin": "compact", "output": "resultado_cpp_steal_O3.csv"},
         {"name": "Java", "flags": "", "output": "resultado_java.csv"},
         {"name": "Python", "flags": "", "output": "resultado_python.csv"},
     ],
 }
 
+if os.environ.get("BLAS_LIB"):
+    flags = f"-std=c++17 -Wall -Wextra -pthread -O3 -DMATRIZ_BLAS -l{os.environ['BLAS_LIB']}"
+    data["languages"][-2:-2] = [
+        {"name": "C++", "flags": flags, "kernel": "blas", "dtype": "double", "output": "resultado_cpp_blas_O3.csv"},
+        {"name": "C++", "flags": flags, "kernel": "blas", "dtype": "double", "mode": "threads-sweep",
+         "output": "resultado_cpp_blas_scaling_O3.csv"},
+    ]
+
+# Metadados gravados pelo proprio benchmark (--meta-json), como o ISA escolhido.
+out_dir = os.path.dirname(os.environ["MANIFEST_PATH"])
+for language in data["languages"]:
+    meta_path = os.path.join(out_dir, language["output"].replace(".csv", ".meta.json"))
+    if os.path.exists(meta_path):
+        with open(meta_path, encoding="utf-8") as f:
+            language["meta"] = json.load(f)
+        language["isa"] = language["meta"].get("isa", "N/A")
+
 with open(os.environ["MANIFEST_PATH"], "w", encoding="utf-8") as f:
     json.dump(data, f, ensure_ascii=False, indent=2)
     f.write("\n")
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Leitura e escrita do formato binario de matriz do benchmark C++ (MATRIZB1).
+
+Cabecalho little-endian de 64 bytes (magic, dtype, tamanho do elemento, rows,
+cols, stride, alignment, offset, reservado) seguido da carga util em `rows`
+linhas de `stride` elementos a partir do byte `offset`. Veja EXECUTION.md.
+
+Uso:
+  python3 scripts/matriz_bin.py info <arquivo>
+  python3 scripts/matriz_bin.py gerar <arquivo> --n 1024 [--dtype float] [--seed 42] [--stride S]
+"""
+from __future__ import annotations
+
+import argparse
+import random
+import struct
+import sys
+from array import array
+from pathlib import Path
+
+
+MAGIC = b"MATRIZB1"
+HEADER = struct.Struct("<8sIIQQQQQQ")
+ALIGNMENT = 4096
+# Codigo do dtype no cabecalho -> (nome, codigo do modulo array, bytes).
+DTYPES = {
+    0: ("int32", "i", 4),
+    1: ("int64", "q", 8),
+    2: ("float", "f", 4),
+    3: ("double", "d", 8),
+}
+
+
+def fail(message: str) -> None:
+    print(f"ERRO: {message}", file=sys.stderr)
+    raise SystemExit(1)
+
+
+def read_header(path: Path) -> dict[str, int | str]:
+    with path.open("rb") as file:
+        raw = file.read(HEADER.size)
+    if len(raw) != HEADER.size:
+        fail(f"Arquivo sem cabecalho: {path}")
+    magic, dtype, elem_size, rows, cols, stride, alignment, offset, _ = HEADER.unpack(raw)
+    if magic != MAGIC or dtype not in DTYPES or DTYPES[dtype][2] != elem_size:
+        fail(f"Cabecalho invalido: {path}")
+    if alignment == 0 or (alignment & (alignment - 1)) != 0:
+        fail(f"Cabecalho invalido: {path}")
+    if stride < cols or offset % alignment != 0 or offset % elem_size != 0 or offset < HEADER.size:
+        fail(f"Cabecalho invalido: {path}")
+    if path.stat().st_size < offset + rows * stride * elem_size:
+        fail(f"Arquivo truncado: {path}")
+    return {
+        "dtype": DTYPES[dtype][0],
+        "rows": rows,
+        "cols": cols,
+        "stride": stride,
+        "alignment": alignment,
+        "offset": offset,
+    }
+
+
+def write_matrix(path: Path, dtype: str, rows: int, cols: int, values: array, stride: int | None = None) -> None:
+    """Grava values (rows x cols, por linhas) com cada linha ocupando stride elementos."""
+    code = next(key for key, (name, _, _) in DTYPES.items() if name == dtype)
+    _, typecode, elem_size = DTYPES[code]
+    stride = cols if stride is None else stride
+    if stride < cols or len(values) != rows * cols:
+        fail("stride menor que cols ou quantidade de valores diferente de rows x cols")
+
+    padding = array(typecode, [0]) * (stride - cols)
+    with path.open("wb") as file:
+        file.write(HEADER.pack(MAGIC, code, elem_size, rows, cols, stride, ALIGNMENT, ALIGNMENT, 0))
+        file.write(b"\0" * (ALIGNMENT - HEADER.size))
+        for row in range(rows):
+            values[row * cols : (row + 1) * cols].tofile(file)
+            padding.tofile(file)
+
+
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(description="Formato binario de matriz MATRIZB1.")
+    commands = parser.add_subparsers(dest="command", required=True)
+    info = commands.add_parser("info", help="mostra o cabecalho")
+    info.add_argument("arquivo", type=Path)
+    generate = commands.add_parser("gerar", help="grava uma matriz N x N aleatoria")
+    generate.add_argument("arquivo", type=Path)
+    generate.add_argument("--n", type=int, required=True)
+    generate.add_argument("--dtype", choices=[name for name, _, _ in DTYPES.values()], default="int32")
+    generate.add_argument("--seed", type=int, default=42)
+    generate.add_argument("--stride", type=int, default=None, help="elementos por linha no arquivo (>= N)")
+    args = parser.parse_args(argv[1:])
+
+    if args.command == "info":
+        for key, value in read_header(args.arquivo).items():
+            print(f"{key}: {value}")
+        return 0
+
+    if args.n < 1:
+        fail("--n deve ser positivo")
+    # Mesmas faixas do --input random do C++: inteiros em [-8, 8], reais em [-1, 1).
+    rng = random.Random(args.seed)
+    typecode = next(code for name, code, _ in DTYPES.values() if name == args.dtype)
+    count = args.n * args.n
+    if typecode in "iq":
+        values = array(typecode, (rng.randint(-8, 8) for _ in range(count)))
+    else:
+        values = array(typecode, (rng.uniform(-1.0, 1.0) for _ in range(count)))
+    write_matrix(args.arquivo, args.dtype, args.n, args.n, values, args.stride)
+    print(f"Matriz {args.n}x{args.n} ({args.dtype}) gravada em {args.arquivo}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main(sys.argv))
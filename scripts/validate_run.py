@@ -16,7 +16,124 @@ EXPECTED_CSVS = [
     "resultado_java.csv",
     "resultado_python.csv",
 ]
+# Variantes de kernel do C++: validadas quando presentes, para que execucoes
+# anteriores a elas continuem validas.
+OPTIONAL_CSVS = [
+    "resultado_cpp_blocked_O3.csv",
+    "resultado_cpp_simd_O3.csv",
+    "resultado_cpp_simd_int64_O3.csv",
+    "resultado_cpp_simd_float_O3.csv",
+    "resultado_cpp_simd_double_O3.csv",
+    "resultado_cpp_arena_O3.csv",
+    "resultado_cpp_hugepage_O3.csv",
+    "resultado_cpp_steal_O3.csv",
+    "resultado_cpp_strassen_O3.csv",
+    "resultado_cpp_simd_random_O3.csv",
+    "resultado_cpp_ooc_O3.csv",
+    "resultado_cpp_blas_O3.csv",
+    "resultado_cpp_morton_O3.csv",
+    "resultado_cpp_packed_O3.csv",
+]
 EXPECTED_HEADER = ["N", "TCS", "TAM", "TDM"]
+# Colunas de --mem-stats (pico de RSS em bytes e faltas de pagina por fase);
+# quando uma aparece, todas devem aparecer.
+MEM_COLUMNS = [
+    "RSS_PICO_TAM",
+    "RSS_PICO_TCS",
+    "RSS_PICO_TDM",
+    "FALTAS_MENORES_TAM",
+    "FALTAS_MAIORES_TAM",
+    "FALTAS_MENORES_TCS",
+    "FALTAS_MAIORES_TCS",
+    "FALTAS_MENORES_TDM",
+    "FALTAS_MAIORES_TDM",
+]
+SCALING_CSV = "resultado_cpp_scaling_O3.csv"
+# Escalonamento do kernel blas, presente so quando o run_all.sh achou uma BLAS.
+BLAS_SCALING_CSV = "resultado_cpp_blas_scaling_O3.csv"
+SCALING_HEADER = ["N", "THREADS", "TCS", "SPEEDUP", "EFICIENCIA"]
+# Estatisticas por thread gravadas com --sched-stats.
+THREAD_STATS_CSVS = ["resultado_cpp_scaling_O3_threads.csv", "resultado_cpp_steal_O3_threads.csv"]
+THREAD_STATS_HEADER = ["N", "THREADS", "THREAD", "TAREFAS", "ROUBOS", "OCUPADO", "OCIOSO"]
+# Contadores de hardware gravados com --perf-stats; N/A quando indisponiveis.
+PERF_CSVS = ["resultado_cpp_O3_perf.csv", "resultado_cpp_blocked_O3_perf.csv"]
+PERF_HEADER = ["N", "THREADS", "CICLOS", "INSTRUCOES", "IPC", "L1D_FALHAS", "LLC_FALHAS", "DTLB_FALHAS"]
+# Tempos por repeticao gravados com --samples.
+SAMPLES_CSVS = ["resultado_cpp_O3_amostras.csv", "resultado_cpp_blocked_O3_amostras.csv"]
+SAMPLES_HEADER = ["N", "THREADS", "REP", "TCS", "TAM", "TDM"]
+# Roofline gravado com --roofline (o do naive tambem vai para system_info.json).
+ROOFLINE_JSONS = [
+    "resultado_cpp_O3.roofline.json",
+    "resultado_cpp_blocked_O3.roofline.json",
+    "resultado_cpp_simd_O3.roofline.json",
+]
+ROOFLINE_KEYS = ["bandwidth_gbs", "peak_gops", "ridge_intensity", "points"]
+# Modo esparso (--sparse): CSR vs kernel denso por N e densidade.
+SPARSE_CSV = "resultado_cpp_sparse_O3.csv"
+SPARSE_HEADER = [
+    "N",
+    "NNZ",
+    "DENSIDADE",
+    "NNZ_RES",
+    "T_DENSO",
+    "T_CONVERSAO",
+    "T_SPMM",
+    "T_SPGEMM",
+    "GANHO_SPMM",
+    "GANHO_SPGEMM",
+    "BYTES_DENSO",
+    "BYTES_CSR",
+]
+# Modo distribuido (--distributed, so Linux): uma linha por N e processo.
+DISTRIBUTED_CSVS = ["resultado_cpp_summa_O3.csv", "resultado_cpp_cannon_O3.csv"]
+DISTRIBUTED_HEADER = ["N", "PROCESSOS", "RANK", "T_TOTAL", "T_COMPUTO", "T_COMUNICACAO", "T_SINCRONIZACAO", "BYTES"]
+# Varredura intercalada de kernels (--sweep): CSV com uma linha por N, kernel
+# e dtype e o mesmo conteudo em JSON (--results-json), com as amostras.
+SWEEP_CSV = "resultado_cpp_sweep_O3.csv"
+SWEEP_JSON = "resultado_cpp_sweep_O3.json"
+SWEEP_HEADER = [
+    "N",
+    "KERNEL",
+    "DTYPE",
+    "ISA",
+    "THREADS",
+    "REPS",
+    "TCS",
+    "TAM",
+    "TDM",
+    "T_CONVERSAO",
+    "T_EMPACOTAMENTO",
+    "TCS_MEDIANA",
+    "TCS_MIN",
+    "TCS_DESVIO",
+    "TCS_P95",
+    "TCS_IC95_INF",
+    "TCS_IC95_SUP",
+    "GOPS",
+]
+SWEEP_KERNELS = {"naive", "blocked", "simd", "strassen", "blas", "morton", "packed"}
+SWEEP_DTYPES = {"int32", "int64", "float", "double"}
+SWEEP_RESULT_KEYS = ["n", "kernel", "dtype", "isa", "threads", "reps", "tcs", "tam", "tdm", "t_convert", "t_pack", "gops", "samples"]
+# GEMM geral (--gemm): uma linha por N, forma e transposicao.
+GEMM_CSV = "resultado_cpp_gemm_O3.csv"
+GEMM_HEADER = ["N", "FORMA", "TRANS", "DTYPE", "DIM_M", "DIM_N", "DIM_K", "TCS", "TAM", "TDM", "TVERIF", "GOPS"]
+GEMM_SHAPES = {"square", "tall", "wide", "inner", "outer"}
+GEMM_TRANS = {"nn", "nt", "tn", "tt"}
+# Autotuner (--tune): so existem na primeira execucao de cada maquina.
+TUNE_CSVS = ["resultado_cpp_tune_blocked_O3.csv", "resultado_cpp_tune_simd_O3.csv"]
+TUNE_HEADER = ["N", "TILE_I", "TILE_J", "TILE_K", "THREADS", "STRASSEN_CUTOFF", "TCS", "TCS_PADRAO", "GANHO"]
+# Modo lote (--batch): kernel especializado vs generico por tamanho.
+BATCH_CSV = "resultado_cpp_batch_O3.csv"
+BATCH_HEADER = [
+    "N",
+    "LOTE",
+    "T_ESPECIALIZADO",
+    "T_GENERICO",
+    "MATS_S_ESPECIALIZADO",
+    "MATS_S_GENERICO",
+    "GFLOPS_ESPECIALIZADO",
+    "GFLOPS_GENERICO",
+]
 
 
 def fail(message: str) -> None:
@@ -35,17 +152,21 @@ def validate_csv(path: Path) -> None:
         except StopIteration:
             fail(f"CSV vazio: {path}")
 
+        # Colunas extras (ex.: ISA do kernel simd) sao permitidas apos as quatro fixas.
         header = [cell.strip() for cell in header]
-        if header != EXPECTED_HEADER:
+        if header[: len(EXPECTED_HEADER)] != EXPECTED_HEADER:
             fail(f"Cabecalho invalido em {path}: {header}. Esperado: {EXPECTED_HEADER}")
+        mem_indexes = [header.index(column) for column in MEM_COLUMNS if column in header]
+        if mem_indexes and len(mem_indexes) != len(MEM_COLUMNS):
+            fail(f"Cabecalho de {path} tem so parte das colunas de memoria: {MEM_COLUMNS}")
 
         rows = 0
         previous_n: int | None = None
         for line_number, row in enumerate(reader, start=2):
             if not row or all(not cell.strip() for cell in row):
                 continue
-            if len(row) != len(EXPECTED_HEADER):
-                fail(f"Linha {line_number} de {path} tem {len(row)} colunas; esperado {len(EXPECTED_HEADER)}")
+            if len(row) != len(header):
+                fail(f"Linha {line_number} de {path} tem {len(row)} colunas; esperado {len(header)}")
 
             try:
                 n = int(row[0])
@@ -63,6 +184,14 @@ def validate_csv(path: Path) -> None:
                 fail(f"Linha {line_number} de {path} tem tempo negativo")
             if not all(math.isfinite(value) for value in (tcs, tam, tdm)):
                 fail(f"Linha {line_number} de {path} contem NaN ou Inf")
+            try:
+                memory = [float(row[index]) for index in mem_indexes]
+            except ValueError as exc:
+                fail(f"Linha {line_number} de {path} contem memoria nao numerica: {exc}")
+            if any(not math.isfinite(value) or value < 0 for value in memory):
+                fail(f"Linha {line_number} de {path} tem memoria negativa, NaN ou Inf")
+            if memory and min(memory[:3]) <= 0:
+                fail(f"Linha {line_number} de {path} tem pico de RSS zerado")
 
             previous_n = n
             rows += 1
@@ -71,6 +200,115 @@ def validate_csv(path: Path) -> None:
         fail(f"CSV sem dados: {path}")
 
 
+def validate_scaling_csv(
+    path: Path, expected_header: list[str], allow_missing: bool = False, min_count: int = 1
+) -> None:
+    """Valida CSVs com N e uma contagem inteira (THREADS, LOTE) seguidos de valores nao negativos.
+
+    Com allow_missing, celulas "N/A" (ex.: contador de hardware indisponivel) sao aceitas; min_count
+    e o menor valor aceito na contagem (0 para NNZ).
+    """
+    with path.open(newline="", encoding="utf-8-sig") as file:
+        reader = csv.reader(file)
+        header = [cell.strip() for cell in next(reader, [])]
+        if header != expected_header:
+            fail(f"Cabecalho invalido em {path}: {header}. Esperado: {expected_header}")
+
+        rows = 0
+        for line_number, row in enumerate(reader, start=2):
+            if not row or all(not cell.strip() for cell in row):
+                continue
+            if len(row) != len(expected_header):
+                fail(f"Linha {line_number} de {path} tem {len(row)} colunas; esperado {len(expected_header)}")
+            try:
+                n = int(row[0])
+                threads = int(row[1])
+                values = [float(cell) for cell in row[2:] if not (allow_missing and cell.strip() == "N/A")]
+            except ValueError as exc:
+                fail(f"Linha {line_number} de {path} contem valor nao numerico: {exc}")
+            if n < 1 or threads < min_count:
+                fail(f"Linha {line_number} de {path} tem N ou {expected_header[1]} invalido")
+            if not all(math.isfinite(value) and value >= 0 for value in values):
+                fail(f"Linha {line_number} de {path} contem valor negativo, NaN ou Inf")
+            rows += 1
+
+    if rows == 0:
+        fail(f"CSV sem dados: {path}")
+
+
+def validate_sweep(csv_path: Path, json_path: Path) -> None:
+    """Valida o CSV da varredura de kernels e, se existir, o JSON com as mesmas linhas."""
+    keys: list[tuple[int, str, str]] = []
+    with csv_path.open(newline="", encoding="utf-8-sig") as file:
+        reader = csv.reader(file)
+        header = [cell.strip() for cell in next(reader, [])]
+        if header != SWEEP_HEADER:
+            fail(f"Cabecalho invalido em {csv_path}: {header}. Esperado: {SWEEP_HEADER}")
+        for line_number, row in enumerate(reader, start=2):
+            if not row or all(not cell.strip() for cell in row):
+                continue
+            if len(row) != len(SWEEP_HEADER):
+                fail(f"Linha {line_number} de {csv_path} tem {len(row)} colunas; esperado {len(SWEEP_HEADER)}")
+            if row[1] not in SWEEP_KERNELS or row[2] not in SWEEP_DTYPES:
+                fail(f"Linha {line_number} de {csv_path} tem kernel ou dtype desconhecido: {row[1]}, {row[2]}")
+            try:
+                n, threads, reps = int(row[0]), int(row[4]), int(row[5])
+                values = [float(cell) for cell in row[6:]]
+            except ValueError as exc:
+                fail(f"Linha {line_number} de {csv_path} contem valor nao numerico: {exc}")
+            if n < 1 or threads < 1 or reps < 1:
+                fail(f"Linha {line_number} de {csv_path} tem N, THREADS ou REPS invalido")
+            # TCS_IC95_INF (media - meia largura) pode ficar negativo com poucas repeticoes.
+            ic_low = SWEEP_HEADER.index("TCS_IC95_INF") - 6
+            if not all(math.isfinite(value) and (value >= 0 or i == ic_low) for i, value in enumerate(values)):
+                fail(f"Linha {line_number} de {csv_path} contem valor negativo, NaN ou Inf")
+            keys.append((n, row[1], row[2]))
+    if not keys:
+        fail(f"CSV sem dados: {csv_path}")
+
+    if not json_path.exists():
+        return
+    validate_json(json_path, ["version", "cpu_model", "order", "results"])
+    results = json.loads(json_path.read_text(encoding="utf-8-sig"))["results"]
+    for index, result in enumerate(results):
+        missing = [key for key in SWEEP_RESULT_KEYS if key not in result]
+        if missing:
+            fail(f"Resultado {index} de {json_path} sem as chaves {missing}")
+        if len(result["samples"]) != result["reps"]:
+            fail(f"Resultado {index} de {json_path} tem {len(result['samples'])} amostras e reps={result['reps']}")
+    if [(result["n"], result["kernel"], result["dtype"]) for result in results] != keys:
+        fail(f"{json_path} nao tem as mesmas linhas (N, kernel, dtype) de {csv_path}")
+
+
+def validate_gemm(path: Path) -> None:
+    """Valida o CSV do GEMM geral: forma, transposicao e dtype conhecidos, dimensoes e tempos validos."""
+    with path.open(newline="", encoding="utf-8-sig") as file:
+        reader = csv.reader(file)
+        header = [cell.strip() for cell in next(reader, [])]
+        if header != GEMM_HEADER:
+            fail(f"Cabecalho invalido em {path}: {header}. Esperado: {GEMM_HEADER}")
+        rows = 0
+        for line_number, row in enumerate(reader, start=2):
+            if not row or all(not cell.strip() for cell in row):
+                continue
+            if len(row) != len(GEMM_HEADER):
+                fail(f"Linha {line_number} de {path} tem {len(row)} colunas; esperado {len(GEMM_HEADER)}")
+            if row[1] not in GEMM_SHAPES or row[2] not in GEMM_TRANS or row[3] not in SWEEP_DTYPES:
+                fail(f"Linha {line_number} de {path} tem forma, transposicao ou dtype desconhecido: {row[1:4]}")
+            try:
+                dims = [int(cell) for cell in (row[0], *row[4:7])]
+                values = [float(cell) for cell in row[7:]]
+            except ValueError as exc:
+                fail(f"Linha {line_number} de {path} contem valor nao numerico: {exc}")
+            if min(dims) < 1:
+                fail(f"Linha {line_number} de {path} tem N, DIM_M, DIM_N ou DIM_K invalido")
+            if not all(math.isfinite(value) and value >= 0 for value in values):
+                fail(f"Linha {line_number} de {path} contem valor negativo, NaN ou Inf")
+            rows += 1
+    if rows == 0:
+        fail(f"CSV sem dados: {path}")
+
+
 def validate_json(path: Path, required_keys: list[str]) -> None:
     if not path.exists():
         fail(f"Arquivo ausente: {path}")
@@ -96,12 +334,45 @@ def main(argv: list[str]) -> int:
 
     for filename in EXPECTED_CSVS:
         validate_csv(run_dir / filename)
+    for filename in OPTIONAL_CSVS:
+        if (run_dir / filename).exists():
+            validate_csv(run_dir / filename)
+    if (run_dir / SCALING_CSV).exists():
+        validate_scaling_csv(run_dir / SCALING_CSV, SCALING_HEADER)
+    if (run_dir / BLAS_SCALING_CSV).exists():
+        validate_scaling_csv(run_dir / BLAS_SCALING_CSV, SCALING_HEADER)
+    for filename in THREAD_STATS_CSVS:
+        if (run_dir / filename).exists():
+            validate_scaling_csv(run_dir / filename, THREAD_STATS_HEADER)
+    for filename in PERF_CSVS:
+        if (run_dir / filename).exists():
+            validate_scaling_csv(run_dir / filename, PERF_HEADER, allow_missing=True)
+    for filename in SAMPLES_CSVS:
+        if (run_dir / filename).exists():
+            validate_scaling_csv(run_dir / filename, SAMPLES_HEADER)
+    if (run_dir / BATCH_CSV).exists():
+        validate_scaling_csv(run_dir / BATCH_CSV, BATCH_HEADER)
+    if (run_dir / SPARSE_CSV).exists():
+        validate_scaling_csv(run_dir / SPARSE_CSV, SPARSE_HEADER, min_count=0)
+    for filename in DISTRIBUTED_CSVS:
+        if (run_dir / filename).exists():
+            validate_scaling_csv(run_dir / filename, DISTRIBUTED_HEADER)
+    if (run_dir / SWEEP_CSV).exists():
+        validate_sweep(run_dir / SWEEP_CSV, run_dir / SWEEP_JSON)
+    if (run_dir / GEMM_CSV).exists():
+        validate_gemm(run_dir / GEMM_CSV)
+    for filename in TUNE_CSVS:
+        if (run_dir / filename).exists():
+            validate_scaling_csv(run_dir / filename, TUNE_HEADER)
 
     system_info_md = run_dir / "system_info.md"
     if not system_info_md.exists() or system_info_md.stat().st_size == 0:
         fail(f"Arquivo ausente ou vazio: {system_info_md}")
 
     validate_json(run_dir / "system_info.json", ["generated_at"])
+    for filename in ROOFLINE_JSONS:
+        if (run_dir / filename).exists():
+            validate_json(run_dir / filename, ROOFLINE_KEYS)
     validate_json(run_dir / "run_manifest.json", ["run_id", "generated_at", "parameters", "languages", "tools"])
 
     pngs = list(run_dir.glob("grafico_*.png"))
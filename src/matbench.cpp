@@ -0,0 +1,6420 @@
+/**********************************************************************
+ * Projeto: Benchmark de Multiplicação de Matrizes
+ * Descrição: Núcleo do benchmark C++ (libmatbench): kernels, alocação,
+ *            temporizadores, verificação e todos os modos de execução.
+ *            Este código realiza a multiplicação de duas matrizes
+ *            de tamanho N x N, variando automaticamente o valor de N
+ *            e medindo o tempo de alocação de memória, cálculo,
+ *            e liberação de memória.
+ *            O código salva os resultados em um arquivo de saída.
+ *            A API pública (C e C++) fica em matbench.h; a linha de
+ *            comando do matriz_cpp (opções e escolha do modo) fica em
+ *            matriz_cpp.cpp, que chama os modos por matbench_internal.h.
+ *
+ * Linguagem: C++
+ *
+ * Autores: Lucas Kriesel Sperotto, Marcos Adriano Silva David
+ * Data: 05/09/2024
+ *
+ * Parâmetros:
+ *  - N: tamanho da matriz (varia de 100 até B)
+ *
+ * Saída: Arquivo de resultados contendo:
+ *  - Tempo de alocação de memória
+ *  - Tempo de cálculo (multiplicação das matrizes)
+ *  - Tempo de liberação de memória
+ *
+ * Uso:
+ *  - Compile e execute o código, e o arquivo de saída será gerado
+ *    contendo os resultados para diferentes valores de N.
+ **********************************************************************/
+
+
+#include "matbench.h"
+#include "matbench_internal.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Kernel blas (opcional): compilado com -DMATRIZ_BLAS e ligado a uma CBLAS
+// instalada (-lopenblas, ou -lblis com -I/usr/include/blis). As funções de
+// threads e versão de OpenBLAS e BLIS são símbolos fracos: usa-se a que a
+// biblioteca ligada tiver.
+#ifdef MATRIZ_BLAS
+#include <cblas.h>
+extern "C" void openblas_set_num_threads(int) __attribute__((weak));
+extern "C" char *openblas_get_config(void) __attribute__((weak));
+extern "C" void bli_thread_set_num_threads(long) __attribute__((weak));
+extern "C" const char *bli_info_get_version_str(void) __attribute__((weak));
+#endif
+
+namespace matbench::detail
+{
+using Clock = std::chrono::steady_clock;
+
+// Região [row_begin, row_end) x [col_begin, col_end) de res.
+struct Tile
+{
+    int row_begin;
+    int row_end;
+    int col_begin;
+    int col_end;
+};
+
+// Contadores de uma thread do escalonador, somados ao longo das repetições.
+struct ThreadStats
+{
+    long long tasks = 0;
+    long long steals = 0;
+    double busy = 0.0;
+    double idle = 0.0;
+    // Empacotamento de painéis do kernel packed (parte de busy).
+    double pack = 0.0;
+};
+
+// Teto de repetições por ponto no modo adaptativo (além de --time-cap).
+static const int kMaxRepetitions = 100000;
+
+static double elapsed_seconds(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int parse_int(const char *text, const std::string &name, int min_value, int max_value)
+{
+    std::string value_text(text);
+    size_t consumed = 0;
+    long value = 0;
+
+    try
+    {
+        value = std::stol(value_text, &consumed, 10);
+    }
+    catch (const std::exception &)
+    {
+        throw std::invalid_argument("Parametro invalido para " + name + ": " + value_text);
+    }
+
+    if (consumed != value_text.size() || value < min_value || value > max_value)
+    {
+        throw std::invalid_argument("Parametro invalido para " + name + ": " + value_text);
+    }
+
+    return static_cast<int>(value);
+}
+
+// Lista de CPUs no formato do Linux (cpulist): "0,2,4-7".
+std::vector<int> parse_cpu_list(const std::string &text, const std::string &name)
+{
+    std::vector<int> cpus;
+    size_t begin = 0;
+    while (begin <= text.size())
+    {
+        const size_t end = std::min(text.find(',', begin), text.size());
+        const std::string item = text.substr(begin, end - begin);
+        const size_t dash = item.find('-');
+        const int first = parse_int(item.substr(0, dash).c_str(), name, 0, 65535);
+        const int last = dash == std::string::npos ? first : parse_int(item.substr(dash + 1).c_str(), name, 0, 65535);
+        if (last < first)
+        {
+            throw std::invalid_argument("Parametro invalido para " + name + ": " + item);
+        }
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+        begin = end + 1;
+    }
+    return cpus;
+}
+
+const char *kernel_name(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Naive:
+        return "naive";
+    case Kernel::Blocked:
+        return "blocked";
+    case Kernel::Simd:
+        return "simd";
+    case Kernel::Strassen:
+        return "strassen";
+    case Kernel::Blas:
+        return "blas";
+    case Kernel::Morton:
+        return "morton";
+    case Kernel::Packed:
+        return "packed";
+    }
+    return "?";
+}
+
+// Kernels cujo micro-kernel vetorial segue --isa.
+bool uses_isa(Kernel kernel)
+{
+    return kernel == Kernel::Simd || kernel == Kernel::Packed;
+}
+
+// O kernel blas só existe compilado com -DMATRIZ_BLAS e só em float/double.
+void check_blas(Kernel kernel, DType dtype)
+{
+    if (kernel != Kernel::Blas)
+    {
+        return;
+    }
+#ifndef MATRIZ_BLAS
+    throw std::invalid_argument("Kernel blas indisponivel nesta compilacao (compile com -DMATRIZ_BLAS e ligue com "
+                                "-lopenblas ou -lblis)");
+#endif
+    if (dtype != DType::Float && dtype != DType::Double)
+    {
+        throw std::invalid_argument("Kernel blas so aceita --dtype float ou double");
+    }
+}
+
+const char *dtype_name(DType dtype)
+{
+    switch (dtype)
+    {
+    case DType::Int32:
+        return "int32";
+    case DType::Int64:
+        return "int64";
+    case DType::Float:
+        return "float";
+    case DType::Double:
+        return "double";
+    }
+    return "?";
+}
+
+static size_t dtype_size(DType dtype)
+{
+    switch (dtype)
+    {
+    case DType::Int64:
+        return sizeof(std::int64_t);
+    case DType::Float:
+        return sizeof(float);
+    case DType::Double:
+        return sizeof(double);
+    case DType::Int32:
+        break;
+    }
+    return sizeof(std::int32_t);
+}
+
+static const char *alloc_name(AllocPolicy policy)
+{
+    switch (policy)
+    {
+    case AllocPolicy::Vector:
+        return "vector";
+    case AllocPolicy::Arena:
+        return "arena";
+    case AllocPolicy::HugePage:
+        return "hugepage";
+    }
+    return "?";
+}
+
+const char *pin_name(Pin pin)
+{
+    switch (pin)
+    {
+    case Pin::None:
+        return "none";
+    case Pin::Compact:
+        return "compact";
+    case Pin::Scatter:
+        return "scatter";
+    case Pin::List:
+        return "list";
+    }
+    return "?";
+}
+
+static const char *dist_algorithm_name(DistAlgorithm algorithm)
+{
+    return algorithm == DistAlgorithm::Cannon ? "cannon" : "summa";
+}
+
+static const char *shape_name(Shape shape)
+{
+    switch (shape)
+    {
+    case Shape::Square:
+        return "square";
+    case Shape::Tall:
+        return "tall";
+    case Shape::Wide:
+        return "wide";
+    case Shape::Inner:
+        return "inner";
+    case Shape::Outer:
+        return "outer";
+    }
+    return "?";
+}
+
+static const char *gemm_trans_name(GemmTrans trans)
+{
+    switch (trans)
+    {
+    case GemmTrans::NN:
+        return "nn";
+    case GemmTrans::NT:
+        return "nt";
+    case GemmTrans::TN:
+        return "tn";
+    case GemmTrans::TT:
+        return "tt";
+    }
+    return "?";
+}
+
+const char *isa_name(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Auto:
+        return "auto";
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::Sse41:
+        return "sse4.1";
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Avx512:
+        return "avx512";
+    }
+    return "?";
+}
+
+#ifdef MATRIZ_X86_SIMD
+static unsigned long long read_xcr0()
+{
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+#endif
+
+// Maior ISA suportado pela CPU *e* habilitado pelo sistema operacional
+// (XCR0), para que o mesmo binário rode em qualquer máquina x86.
+Isa detect_isa()
+{
+#ifdef MATRIZ_X86_SIMD
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1))
+    {
+        return Isa::Scalar;
+    }
+
+    const bool osxsave = (ecx & bit_OSXSAVE) != 0;
+    const bool avx = (ecx & bit_AVX) != 0;
+    if (!osxsave || !avx || (read_xcr0() & 0x6) != 0x6)
+    {
+        return Isa::Sse41;
+    }
+
+    // O nível AVX2 inclui FMA, usado pelos kernels float/double.
+    const bool fma = (ecx & bit_FMA) != 0;
+    if (!fma || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2))
+    {
+        return Isa::Sse41;
+    }
+
+    if ((ebx & bit_AVX512F) && (read_xcr0() & 0xe6) == 0xe6)
+    {
+        return Isa::Avx512;
+    }
+    return Isa::Avx2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+Isa resolve_isa(Isa requested, Isa detected)
+{
+    if (requested == Isa::Auto)
+    {
+        return detected;
+    }
+    if (requested > detected)
+    {
+        throw std::invalid_argument(std::string("ISA ") + isa_name(requested) + " nao suportado nesta CPU (maximo: " +
+                                    isa_name(detected) + ")");
+    }
+    return requested;
+}
+
+static std::string json_string(const std::string &text)
+{
+    std::string out = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+// Inteiros separados por ", " (corpo de um vetor JSON).
+std::string json_int_list(const std::vector<int> &values)
+{
+    std::string out;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        out += (i == 0 ? "" : ", ") + std::to_string(values[i]);
+    }
+    return out;
+}
+
+// JSON mínimo para ler o cache do autotuner: objetos, vetores, strings com
+// escapes simples, números e true/false/null. Lança std::runtime_error.
+struct JsonValue
+{
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type = Type::Null;
+    double number = 0.0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    const JsonValue *find(const std::string &key) const
+    {
+        for (const auto &member : members)
+        {
+            if (member.first == key)
+            {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class JsonReader
+{
+public:
+    explicit JsonReader(const std::string &text) : text_(text) {}
+
+    JsonValue parse()
+    {
+        JsonValue value = parse_value();
+        skip_spaces();
+        if (pos_ != text_.size())
+        {
+            fail();
+        }
+        return value;
+    }
+
+private:
+    [[noreturn]] void fail() const
+    {
+        throw std::runtime_error("JSON invalido na posicao " + std::to_string(pos_));
+    }
+
+    void skip_spaces()
+    {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' ||
+                                        text_[pos_] == '\t'))
+        {
+            pos_++;
+        }
+    }
+
+    bool consume(char c)
+    {
+        skip_spaces();
+        if (pos_ < text_.size() && text_[pos_] == c)
+        {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+        {
+            fail();
+        }
+    }
+
+    bool consume_word(const char *word)
+    {
+        const std::string expected(word);
+        if (text_.compare(pos_, expected.size(), expected) != 0)
+        {
+            return false;
+        }
+        pos_ += expected.size();
+        return true;
+    }
+
+    std::string parse_string()
+    {
+        expect('"');
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"')
+        {
+            char c = text_[pos_++];
+            if (c == '\\')
+            {
+                if (pos_ >= text_.size())
+                {
+                    fail();
+                }
+                c = text_[pos_++];
+                if (c == 'n')
+                {
+                    c = '\n';
+                }
+                else if (c == 't')
+                {
+                    c = '\t';
+                }
+                else if (c != '"' && c != '\\' && c != '/')
+                {
+                    fail();
+                }
+            }
+            out += c;
+        }
+        expect('"');
+        return out;
+    }
+
+    JsonValue parse_value()
+    {
+        JsonValue value;
+        skip_spaces();
+        if (pos_ >= text_.size())
+        {
+            fail();
+        }
+
+        const char c = text_[pos_];
+        if (c == '{')
+        {
+            pos_++;
+            value.type = JsonValue::Type::Object;
+            if (consume('}'))
+            {
+                return value;
+            }
+            do
+            {
+                skip_spaces();
+                std::string key = parse_string();
+                expect(':');
+                value.members.emplace_back(std::move(key), parse_value());
+            } while (consume(','));
+            expect('}');
+        }
+        else if (c == '[')
+        {
+            pos_++;
+            value.type = JsonValue::Type::Array;
+            if (consume(']'))
+            {
+                return value;
+            }
+            do
+            {
+                value.items.push_back(parse_value());
+            } while (consume(','));
+            expect(']');
+        }
+        else if (c == '"')
+        {
+            value.type = JsonValue::Type::String;
+            value.text = parse_string();
+        }
+        else if (consume_word("true"))
+        {
+            value.type = JsonValue::Type::Bool;
+            value.number = 1.0;
+        }
+        else if (consume_word("false"))
+        {
+            value.type = JsonValue::Type::Bool;
+        }
+        else if (consume_word("null"))
+        {
+            value.type = JsonValue::Type::Null;
+        }
+        else
+        {
+            const char *begin = text_.c_str() + pos_;
+            char *end = nullptr;
+            value.type = JsonValue::Type::Number;
+            value.number = std::strtod(begin, &end);
+            if (end == begin)
+            {
+                fail();
+            }
+            pos_ += static_cast<size_t>(end - begin);
+        }
+        return value;
+    }
+
+    const std::string &text_;
+    size_t pos_ = 0;
+};
+
+std::vector<int> make_points(int b, int npts, int escala)
+{
+    const double a = 100.0;
+    std::vector<int> points;
+    points.reserve(static_cast<size_t>(npts));
+
+    if (escala == 1)
+    {
+        const double step = (static_cast<double>(b) - a) / static_cast<double>(npts - 1);
+        for (int i = 0; i < npts; i++)
+        {
+            points.push_back(static_cast<int>(std::round(a + step * i)));
+        }
+    }
+    else
+    {
+        const double ratio = std::pow(static_cast<double>(b) / a, 1.0 / static_cast<double>(npts - 1));
+        for (int i = 0; i < npts; i++)
+        {
+            points.push_back(static_cast<int>(std::round(a * std::pow(ratio, i))));
+        }
+    }
+
+    return points;
+}
+
+// Os kernels calculam apenas a região tile de res, para que as versões
+// paralelas possam repartir a matriz em blocos de linhas ou em blocos 2-D.
+template <typename T>
+static void multiply(const T *mat1, const T *mat2, T *res, int n, const Tile &tile)
+{
+    for (int i = tile.row_begin; i < tile.row_end; i++)
+    {
+        for (int j = tile.col_begin; j < tile.col_end; j++)
+        {
+            T sum = 0;
+            for (int k = 0; k < n; k++)
+            {
+                sum += mat1[static_cast<size_t>(i) * n + k] * mat2[static_cast<size_t>(k) * n + j];
+            }
+            res[static_cast<size_t>(i) * n + j] = sum;
+        }
+    }
+}
+
+// Zera a região de res que um kernel acumulativo vai calcular.
+template <typename T>
+static void clear_tile(T *res, int n, const Tile &tile)
+{
+    for (int i = tile.row_begin; i < tile.row_end; i++)
+    {
+        T *row = res + static_cast<size_t>(i) * n;
+        std::fill(row + tile.col_begin, row + tile.col_end, T(0));
+    }
+}
+
+// Mesmo produto em blocos (tile_i x tile_k x tile_j) com ordem i-k-j no
+// bloco: a linha de mat2 e a de res são percorridas com passo unitário.
+template <typename T>
+static void multiply_blocked(const T *mat1, const T *mat2, T *res, int n, const Tile &tile, const Options &options)
+{
+    clear_tile(res, n, tile);
+
+    for (int ii = tile.row_begin; ii < tile.row_end; ii += options.tile_i)
+    {
+        const int i_end = std::min(ii + options.tile_i, tile.row_end);
+        for (int kk = 0; kk < n; kk += options.tile_k)
+        {
+            const int k_end = std::min(kk + options.tile_k, n);
+            for (int jj = tile.col_begin; jj < tile.col_end; jj += options.tile_j)
+            {
+                const int j_end = std::min(jj + options.tile_j, tile.col_end);
+                for (int i = ii; i < i_end; i++)
+                {
+                    T *res_row = &res[static_cast<size_t>(i) * n];
+                    for (int k = kk; k < k_end; k++)
+                    {
+                        const T a = mat1[static_cast<size_t>(i) * n + k];
+                        const T *mat2_row = &mat2[static_cast<size_t>(k) * n];
+                        for (int j = jj; j < j_end; j++)
+                        {
+                            res_row[j] += a * mat2_row[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#ifdef MATRIZ_X86_SIMD
+// Gera um kernel em blocos com a mesma ordem de multiply_blocked, mas com
+// o laço em j feito por vetores de W elementos: 4 acumuladores por linha
+// de res, um broadcast de mat1[i][k] e uma linha contígua de mat2 por k.
+// MAC(c, a, b) devolve c + a * b (FMA quando o tipo e o ISA permitem).
+// Cada instância é uma sobrecarga de NAME para o tipo T.
+#define MATRIZ_SIMD_KERNEL(NAME, TARGET, T, VEC, W, LOAD, STORE, SET1, MAC)                                     \
+    __attribute__((target(TARGET))) static void NAME(const T *mat1, const T *mat2, T *res, int n,             \
+                                                     const Tile &tile, const Options &options)                \
+    {                                                                                                         \
+        clear_tile(res, n, tile);                                                                             \
+        for (int ii = tile.row_begin; ii < tile.row_end; ii += options.tile_i)                                \
+        {                                                                                                     \
+            const int i_end = std::min(ii + options.tile_i, tile.row_end);                                    \
+            for (int kk = 0; kk < n; kk += options.tile_k)                                                    \
+            {                                                                                                 \
+                const int k_end = std::min(kk + options.tile_k, n);                                           \
+                for (int jj = tile.col_begin; jj < tile.col_end; jj += options.tile_j)                        \
+                {                                                                                             \
+                    const int j_end = std::min(jj + options.tile_j, tile.col_end);                            \
+                    for (int i = ii; i < i_end; i++)                                                          \
+                    {                                                                                         \
+                        const T *a_row = mat1 + static_cast<size_t>(i) * n;                                   \
+                        T *c_row = res + static_cast<size_t>(i) * n;                                          \
+                        int j = jj;                                                                           \
+                        for (; j + 4 * (W) <= j_end; j += 4 * (W))                                            \
+                        {                                                                                     \
+                            VEC c0 = LOAD(c_row + j);                                                         \
+                            VEC c1 = LOAD(c_row + j + (W));                                                   \
+                            VEC c2 = LOAD(c_row + j + 2 * (W));                                               \
+                            VEC c3 = LOAD(c_row + j + 3 * (W));                                               \
+                            for (int k = kk; k < k_end; k++)                                                  \
+                            {                                                                                 \
+                                const VEC a = SET1(a_row[k]);                                                 \
+                                const T *b = mat2 + static_cast<size_t>(k) * n + j;                           \
+                                c0 = MAC(c0, a, LOAD(b));                                                     \
+                                c1 = MAC(c1, a, LOAD(b + (W)));                                               \
+                                c2 = MAC(c2, a, LOAD(b + 2 * (W)));                                           \
+                                c3 = MAC(c3, a, LOAD(b + 3 * (W)));                                           \
+                            }                                                                                 \
+                            STORE(c_row + j, c0);                                                             \
+                            STORE(c_row + j + (W), c1);                                                       \
+                            STORE(c_row + j + 2 * (W), c2);                                                   \
+                            STORE(c_row + j + 3 * (W), c3);                                                   \
+                        }                                                                                     \
+                        for (; j + (W) <= j_end; j += (W))                                                    \
+                        {                                                                                     \
+                            VEC c0 = LOAD(c_row + j);                                                         \
+                            for (int k = kk; k < k_end; k++)                                                  \
+                            {                                                                                 \
+                                c0 = MAC(c0, SET1(a_row[k]), LOAD(mat2 + static_cast<size_t>(k) * n + j));    \
+                            }                                                                                 \
+                            STORE(c_row + j, c0);                                                             \
+                        }                                                                                     \
+                        for (; j < j_end; j++)                                                                \
+                        {                                                                                     \
+                            T sum = c_row[j];                                                                 \
+                            for (int k = kk; k < k_end; k++)                                                  \
+                            {                                                                                 \
+                                sum += a_row[k] * mat2[static_cast<size_t>(k) * n + j];                       \
+                            }                                                                                 \
+                            c_row[j] = sum;                                                                   \
+                        }                                                                                     \
+                    }                                                                                         \
+                }                                                                                             \
+            }                                                                                                 \
+        }                                                                                                     \
+    }
+
+#define MATRIZ_SSE_LOAD(p) _mm_loadu_si128(reinterpret_cast<const __m128i *>(p))
+#define MATRIZ_SSE_STORE(p, v) _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v)
+#define MATRIZ_AVX2_LOAD(p) _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))
+#define MATRIZ_AVX2_STORE(p, v) _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v)
+
+#define MATRIZ_SSE_I32_MAC(c, a, b) _mm_add_epi32(c, _mm_mullo_epi32(a, b))
+#define MATRIZ_SSE_F32_MAC(c, a, b) _mm_add_ps(c, _mm_mul_ps(a, b))
+#define MATRIZ_SSE_F64_MAC(c, a, b) _mm_add_pd(c, _mm_mul_pd(a, b))
+#define MATRIZ_AVX2_I32_MAC(c, a, b) _mm256_add_epi32(c, _mm256_mullo_epi32(a, b))
+#define MATRIZ_AVX2_F32_MAC(c, a, b) _mm256_fmadd_ps(a, b, c)
+#define MATRIZ_AVX2_F64_MAC(c, a, b) _mm256_fmadd_pd(a, b, c)
+#define MATRIZ_AVX512_I32_MAC(c, a, b) _mm512_add_epi32(c, _mm512_mullo_epi32(a, b))
+#define MATRIZ_AVX512_F32_MAC(c, a, b) _mm512_fmadd_ps(a, b, c)
+#define MATRIZ_AVX512_F64_MAC(c, a, b) _mm512_fmadd_pd(a, b, c)
+
+MATRIZ_SIMD_KERNEL(multiply_sse41, "sse4.1", std::int32_t, __m128i, 4, MATRIZ_SSE_LOAD, MATRIZ_SSE_STORE,
+                   _mm_set1_epi32, MATRIZ_SSE_I32_MAC)
+MATRIZ_SIMD_KERNEL(multiply_sse41, "sse4.1", float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps,
+                   MATRIZ_SSE_F32_MAC)
+MATRIZ_SIMD_KERNEL(multiply_sse41, "sse4.1", double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd,
+                   MATRIZ_SSE_F64_MAC)
+MATRIZ_SIMD_KERNEL(multiply_avx2, "avx2", std::int32_t, __m256i, 8, MATRIZ_AVX2_LOAD, MATRIZ_AVX2_STORE,
+                   _mm256_set1_epi32, MATRIZ_AVX2_I32_MAC)
+MATRIZ_SIMD_KERNEL(multiply_avx2, "avx2,fma", float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+                   MATRIZ_AVX2_F32_MAC)
+MATRIZ_SIMD_KERNEL(multiply_avx2, "avx2,fma", double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd,
+                   _mm256_set1_pd, MATRIZ_AVX2_F64_MAC)
+MATRIZ_SIMD_KERNEL(multiply_avx512, "avx512f", std::int32_t, __m512i, 16, _mm512_loadu_si512, _mm512_storeu_si512,
+                   _mm512_set1_epi32, MATRIZ_AVX512_I32_MAC)
+MATRIZ_SIMD_KERNEL(multiply_avx512, "avx512f", float, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps,
+                   _mm512_set1_ps, MATRIZ_AVX512_F32_MAC)
+MATRIZ_SIMD_KERNEL(multiply_avx512, "avx512f", double, __m512d, 8, _mm512_loadu_pd, _mm512_storeu_pd,
+                   _mm512_set1_pd, MATRIZ_AVX512_F64_MAC)
+
+// Pico de computação (--roofline): 12 cadeias independentes de MAC escondem
+// a latência; cada passo faz acc += acc * up e depois acc += acc * down. Em
+// ponto flutuante up = -down = 1e-3 e o fator do passo fica logo abaixo de 1,
+// então os valores não explodem nem viram subnormais; em inteiros up = down =
+// -2 e o passo só troca o sinal duas vezes, sem zerar nem estourar. Devolve o
+// número de operações (2 por elemento por MAC).
+#define MATRIZ_PEAK_KERNEL(NAME, TARGET, T, VEC, W, STORE, SET1, MAC)                                          \
+    __attribute__((target(TARGET))) static double NAME(T up, T down, long long iterations, T *sink)          \
+    {                                                                                                         \
+        const VEC vup = SET1(up);                                                                             \
+        const VEC vdown = SET1(down);                                                                         \
+        VEC acc[12];                                                                                          \
+        for (int a = 0; a < 12; a++)                                                                          \
+        {                                                                                                     \
+            acc[a] = SET1(static_cast<T>(a + 1));                                                             \
+        }                                                                                                     \
+        for (long long it = 0; it < iterations; it++)                                                         \
+        {                                                                                                     \
+            for (int a = 0; a < 12; a++)                                                                      \
+            {                                                                                                 \
+                acc[a] = MAC(acc[a], acc[a], vup);                                                            \
+            }                                                                                                 \
+            for (int a = 0; a < 12; a++)                                                                      \
+            {                                                                                                 \
+                acc[a] = MAC(acc[a], acc[a], vdown);                                                          \
+            }                                                                                                 \
+        }                                                                                                     \
+        for (int a = 0; a < 12; a++)                                                                          \
+        {                                                                                                     \
+            STORE(sink + a * (W), acc[a]);                                                                    \
+        }                                                                                                     \
+        return static_cast<double>(iterations) * 2.0 * 12.0 * (W) * 2.0;                                      \
+    }
+
+MATRIZ_PEAK_KERNEL(peak_sse41, "sse4.1", std::int32_t, __m128i, 4, MATRIZ_SSE_STORE, _mm_set1_epi32,
+                   MATRIZ_SSE_I32_MAC)
+MATRIZ_PEAK_KERNEL(peak_sse41, "sse4.1", float, __m128, 4, _mm_storeu_ps, _mm_set1_ps, MATRIZ_SSE_F32_MAC)
+MATRIZ_PEAK_KERNEL(peak_sse41, "sse4.1", double, __m128d, 2, _mm_storeu_pd, _mm_set1_pd, MATRIZ_SSE_F64_MAC)
+MATRIZ_PEAK_KERNEL(peak_avx2, "avx2", std::int32_t, __m256i, 8, MATRIZ_AVX2_STORE, _mm256_set1_epi32,
+                   MATRIZ_AVX2_I32_MAC)
+MATRIZ_PEAK_KERNEL(peak_avx2, "avx2,fma", float, __m256, 8, _mm256_storeu_ps, _mm256_set1_ps, MATRIZ_AVX2_F32_MAC)
+MATRIZ_PEAK_KERNEL(peak_avx2, "avx2,fma", double, __m256d, 4, _mm256_storeu_pd, _mm256_set1_pd,
+                   MATRIZ_AVX2_F64_MAC)
+MATRIZ_PEAK_KERNEL(peak_avx512, "avx512f", std::int32_t, __m512i, 16, _mm512_storeu_si512, _mm512_set1_epi32,
+                   MATRIZ_AVX512_I32_MAC)
+MATRIZ_PEAK_KERNEL(peak_avx512, "avx512f", float, __m512, 16, _mm512_storeu_ps, _mm512_set1_ps,
+                   MATRIZ_AVX512_F32_MAC)
+MATRIZ_PEAK_KERNEL(peak_avx512, "avx512f", double, __m512d, 8, _mm512_storeu_pd, _mm512_set1_pd,
+                   MATRIZ_AVX512_F64_MAC)
+#endif
+
+// int64 não tem micro-kernel (não há multiplicação de 64 bits em SSE4.1 e
+// AVX2); main já força o ISA para scalar nesse caso.
+template <typename T>
+static void multiply_simd(const T *mat1, const T *mat2, T *res, int n, const Tile &tile, const Options &options)
+{
+    if constexpr (std::is_same<T, std::int64_t>::value)
+    {
+        multiply_blocked(mat1, mat2, res, n, tile, options);
+    }
+    else
+    {
+        switch (options.isa)
+        {
+#ifdef MATRIZ_X86_SIMD
+        case Isa::Sse41:
+            multiply_sse41(mat1, mat2, res, n, tile, options);
+            return;
+        case Isa::Avx2:
+            multiply_avx2(mat1, mat2, res, n, tile, options);
+            return;
+        case Isa::Avx512:
+            multiply_avx512(mat1, mat2, res, n, tile, options);
+            return;
+#endif
+        default:
+            multiply_blocked(mat1, mat2, res, n, tile, options);
+            return;
+        }
+    }
+}
+
+// Kernel packed (estilo GotoBLAS): para cada painel de NC colunas de res
+// (L3) e fatia de KC de k, B[KC x NC] é copiado em micro-painéis de NR
+// colunas contíguos por k (L1 por micro-painel); para cada bloco de MC
+// linhas, A[MC x KC] vira micro-painéis de MR linhas (L2). O micro-kernel
+// acumula um bloco MR x NR de res em registradores ao longo de KC, lendo só
+// memória contígua, o que elimina as falhas de TLB e de conflito dos passos
+// de N elementos. Os painéis são completados com zeros até múltiplos de MR
+// e NR, então os blocos de borda (N qualquer) usam o mesmo micro-kernel e
+// só a soma em res é recortada.
+static const int kPackedMr = 6;
+
+// Micro-kernel: c[rows x cols] += a_panel x b_panel, com a_panel kc x MR e
+// b_panel kc x NR (NR = 2 vetores de W), 2 * MR acumuladores vetoriais.
+template <typename T>
+struct PackedMicro
+{
+    int nr;
+    void (*run)(int kc, const T *a, const T *b, T *c, size_t ldc, int rows, int cols);
+};
+
+// Versão escalar (int64, ISA scalar e CPUs não x86), NR = 4.
+static const int kPackedScalarNr = 4;
+
+template <typename T>
+static void packed_micro_scalar(int kc, const T *a, const T *b, T *c, size_t ldc, int rows, int cols)
+{
+    T acc[kPackedMr][kPackedScalarNr] = {};
+    for (int p = 0; p < kc; p++)
+    {
+        const T *bp = b + static_cast<size_t>(p) * kPackedScalarNr;
+        for (int i = 0; i < kPackedMr; i++)
+        {
+            const T ai = a[static_cast<size_t>(p) * kPackedMr + i];
+            for (int j = 0; j < kPackedScalarNr; j++)
+            {
+                acc[i][j] += ai * bp[j];
+            }
+        }
+    }
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            c[static_cast<size_t>(i) * ldc + j] += acc[i][j];
+        }
+    }
+}
+
+#ifdef MATRIZ_X86_SIMD
+// MAC(c, 1, acc) soma o acumulador em res com as mesmas macros dos kernels simd.
+#define MATRIZ_PACKED_MICRO(NAME, TARGET, T, VEC, W, LOAD, STORE, SET1, MAC)                                   \
+    __attribute__((target(TARGET))) static void NAME(int kc, const T *a, const T *b, T *c, size_t ldc,       \
+                                                     int rows, int cols)                                      \
+    {                                                                                                         \
+        VEC acc[kPackedMr][2];                                                                                \
+        for (int i = 0; i < kPackedMr; i++)                                                                   \
+        {                                                                                                     \
+            acc[i][0] = SET1(T(0));                                                                           \
+            acc[i][1] = SET1(T(0));                                                                           \
+        }                                                                                                     \
+        for (int p = 0; p < kc; p++)                                                                          \
+        {                                                                                                     \
+            const VEC b0 = LOAD(b + static_cast<size_t>(p) * 2 * (W));                                        \
+            const VEC b1 = LOAD(b + static_cast<size_t>(p) * 2 * (W) + (W));                                  \
+            for (int i = 0; i < kPackedMr; i++)                                                               \
+            {                                                                                                 \
+                const VEC ai = SET1(a[static_cast<size_t>(p) * kPackedMr + i]);                               \
+                acc[i][0] = MAC(acc[i][0], ai, b0);                                                           \
+                acc[i][1] = MAC(acc[i][1], ai, b1);                                                           \
+            }                                                                                                 \
+        }                                                                                                     \
+        const VEC one = SET1(T(1));                                                                           \
+        if (rows == kPackedMr && cols == 2 * (W))                                                             \
+        {                                                                                                     \
+            for (int i = 0; i < kPackedMr; i++)                                                               \
+            {                                                                                                 \
+                T *row = c + static_cast<size_t>(i) * ldc;                                                    \
+                STORE(row, MAC(LOAD(row), one, acc[i][0]));                                                   \
+                STORE(row + (W), MAC(LOAD(row + (W)), one, acc[i][1]));                                       \
+            }                                                                                                 \
+            return;                                                                                           \
+        }                                                                                                     \
+        T tile[kPackedMr * 2 * (W)];                                                                          \
+        for (int i = 0; i < kPackedMr; i++)                                                                   \
+        {                                                                                                     \
+            STORE(tile + i * 2 * (W), acc[i][0]);                                                             \
+            STORE(tile + i * 2 * (W) + (W), acc[i][1]);                                                       \
+        }                                                                                                     \
+        for (int i = 0; i < rows; i++)                                                                        \
+        {                                                                                                     \
+            for (int j = 0; j < cols; j++)                                                                    \
+            {                                                                                                 \
+                c[static_cast<size_t>(i) * ldc + j] += tile[i * 2 * (W) + j];                                 \
+            }                                                                                                 \
+        }                                                                                                     \
+    }
+
+MATRIZ_PACKED_MICRO(packed_micro_sse41, "sse4.1", std::int32_t, __m128i, 4, MATRIZ_SSE_LOAD, MATRIZ_SSE_STORE,
+                    _mm_set1_epi32, MATRIZ_SSE_I32_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_sse41, "sse4.1", float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_set1_ps,
+                    MATRIZ_SSE_F32_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_sse41, "sse4.1", double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd,
+                    MATRIZ_SSE_F64_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_avx2, "avx2", std::int32_t, __m256i, 8, MATRIZ_AVX2_LOAD, MATRIZ_AVX2_STORE,
+                    _mm256_set1_epi32, MATRIZ_AVX2_I32_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_avx2, "avx2,fma", float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps,
+                    _mm256_set1_ps, MATRIZ_AVX2_F32_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_avx2, "avx2,fma", double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd,
+                    _mm256_set1_pd, MATRIZ_AVX2_F64_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_avx512, "avx512f", std::int32_t, __m512i, 16, _mm512_loadu_si512,
+                    _mm512_storeu_si512, _mm512_set1_epi32, MATRIZ_AVX512_I32_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_avx512, "avx512f", float, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps,
+                    _mm512_set1_ps, MATRIZ_AVX512_F32_MAC)
+MATRIZ_PACKED_MICRO(packed_micro_avx512, "avx512f", double, __m512d, 8, _mm512_loadu_pd, _mm512_storeu_pd,
+                    _mm512_set1_pd, MATRIZ_AVX512_F64_MAC)
+#endif
+
+// Micro-kernel do ISA escolhido; int64 usa sempre o escalar.
+template <typename T>
+static PackedMicro<T> packed_micro(Isa isa)
+{
+    if constexpr (!std::is_same<T, std::int64_t>::value)
+    {
+        switch (isa)
+        {
+#ifdef MATRIZ_X86_SIMD
+        case Isa::Sse41:
+            return {2 * static_cast<int>(16 / sizeof(T)), packed_micro_sse41};
+        case Isa::Avx2:
+            return {2 * static_cast<int>(32 / sizeof(T)), packed_micro_avx2};
+        case Isa::Avx512:
+            return {2 * static_cast<int>(64 / sizeof(T)), packed_micro_avx512};
+#endif
+        default:
+            break;
+        }
+    }
+    return {kPackedScalarNr, packed_micro_scalar<T>};
+}
+
+// Tamanhos de L1d, L2 e L3 em bytes (sysconf do glibc, com padrões de 32 KiB,
+// 1 MiB e 8 MiB), lidos uma vez por processo.
+struct CacheSizes
+{
+    long l1;
+    long l2;
+    long l3;
+};
+
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+static long cache_bytes(int name, long fallback)
+{
+    const long bytes = sysconf(name);
+    return bytes > 0 ? bytes : fallback;
+}
+#endif
+
+static const CacheSizes &cache_sizes()
+{
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    static const CacheSizes sizes = {cache_bytes(_SC_LEVEL1_DCACHE_SIZE, 32 * 1024),
+                                     cache_bytes(_SC_LEVEL2_CACHE_SIZE, 1024 * 1024),
+                                     cache_bytes(_SC_LEVEL3_CACHE_SIZE, 8 * 1024 * 1024)};
+#else
+    static const CacheSizes sizes = {32 * 1024, 1024 * 1024, 8 * 1024 * 1024};
+#endif
+    return sizes;
+}
+
+// Blocos do kernel packed: KC com um micro-painel de B (KC x NR) em meia
+// L1, MC com o bloco de A (MC x KC) em meia L2 e NC com o painel de B
+// (KC x NC) em meia L3, arredondados para múltiplos de MR e NR. --tile-i,
+// --tile-k e --tile-j passados na linha de comando substituem MC, KC e NC.
+struct PackedBlocking
+{
+    int mc;
+    int kc;
+    int nc;
+};
+
+static PackedBlocking packed_blocking(int nr, size_t elem_size, const Options &options)
+{
+    const long elem = static_cast<long>(elem_size);
+    const CacheSizes &caches = cache_sizes();
+    PackedBlocking block;
+    block.kc = static_cast<int>(std::clamp(caches.l1 / 2 / (nr * elem), 64L, 1024L));
+    block.mc = static_cast<int>(std::clamp(caches.l2 / 2 / (block.kc * elem), 16L, 1024L));
+    block.mc -= block.mc % kPackedMr;
+    block.nc = static_cast<int>(std::clamp(caches.l3 / 2 / (block.kc * elem), 256L, 16384L));
+    block.nc -= block.nc % nr;
+    if (options.given.count("--tile-i") != 0)
+    {
+        block.mc = options.tile_i;
+    }
+    if (options.given.count("--tile-k") != 0)
+    {
+        block.kc = options.tile_k;
+    }
+    if (options.given.count("--tile-j") != 0)
+    {
+        block.nc = options.tile_j;
+    }
+    return block;
+}
+
+// mat1[ic..ic+mc)[pc..pc+kc) em micro-painéis de MR linhas: para cada k,
+// os MR valores da coluna em sequência; linhas além de mc ficam zeradas.
+template <typename T>
+static void pack_a(const T *mat1, int n, int ic, int mc, int pc, int kc, T *packed)
+{
+    for (int ir = 0; ir < mc; ir += kPackedMr)
+    {
+        T *panel = packed + static_cast<size_t>(ir) * kc;
+        const int rows = std::min(kPackedMr, mc - ir);
+        for (int p = 0; p < kc; p++)
+        {
+            T *out = panel + static_cast<size_t>(p) * kPackedMr;
+            for (int i = 0; i < rows; i++)
+            {
+                out[i] = mat1[static_cast<size_t>(ic + ir + i) * n + pc + p];
+            }
+            std::fill(out + rows, out + kPackedMr, T(0));
+        }
+    }
+}
+
+// mat2[pc..pc+kc)[jc..jc+nc) em micro-painéis de NR colunas: para cada k,
+// os NR valores da linha em sequência; colunas além de nc ficam zeradas.
+template <typename T>
+static void pack_b(const T *mat2, int n, int pc, int kc, int jc, int nc, int nr, T *packed)
+{
+    for (int jr = 0; jr < nc; jr += nr)
+    {
+        T *panel = packed + static_cast<size_t>(jr) * kc;
+        const int cols = std::min(nr, nc - jr);
+        for (int p = 0; p < kc; p++)
+        {
+            const T *in = mat2 + static_cast<size_t>(pc + p) * n + jc + jr;
+            T *out = panel + static_cast<size_t>(p) * nr;
+            std::copy(in, in + cols, out);
+            std::fill(out + cols, out + nr, T(0));
+        }
+    }
+}
+
+// Linha de console com o micro-kernel e os blocos usados em options.dtype.
+void print_packed_blocking(const Options &options)
+{
+    int nr = kPackedScalarNr;
+    switch (options.dtype)
+    {
+    case DType::Int32:
+        nr = packed_micro<std::int32_t>(options.isa).nr;
+        break;
+    case DType::Float:
+        nr = packed_micro<float>(options.isa).nr;
+        break;
+    case DType::Double:
+        nr = packed_micro<double>(options.isa).nr;
+        break;
+    case DType::Int64:
+        break;
+    }
+    const PackedBlocking block = packed_blocking(nr, dtype_size(options.dtype), options);
+    std::cout << "Kernel packed: micro-kernel " << kPackedMr << "x" << nr << ", MC = " << block.mc
+              << ", KC = " << block.kc << ", NC = " << block.nc << " (caches L1/L2/L3 de " << cache_sizes().l1 / 1024
+              << "/" << cache_sizes().l2 / 1024 << "/" << cache_sizes().l3 / 1024 << " KiB).\n";
+}
+
+template <typename T>
+static void run_tile(const T *mat1, const T *mat2, T *res, int n, const Tile &tile, const Options &options)
+{
+    switch (options.kernel)
+    {
+    case Kernel::Naive:
+        multiply(mat1, mat2, res, n, tile);
+        break;
+    case Kernel::Blocked:
+        multiply_blocked(mat1, mat2, res, n, tile, options);
+        break;
+    case Kernel::Simd:
+        multiply_simd(mat1, mat2, res, n, tile, options);
+        break;
+    case Kernel::Strassen:
+    case Kernel::Blas:
+    case Kernel::Morton:
+    case Kernel::Packed:
+        // Strassen, blas, morton e packed não se dividem em blocos de res; run_kernel os trata antes.
+        multiply_blocked(mat1, mat2, res, n, tile, options);
+        break;
+    }
+}
+
+// Fila de uma thread; alinhada para que os mutexes de threads vizinhas não
+// dividam a mesma linha de cache.
+struct alignas(64) TaskQueue
+{
+    std::mutex mutex;
+    std::deque<Tile> tiles;
+};
+
+// O dono consome pelo fim da própria fila; quem ficou sem trabalho rouba
+// pelo início das filas das outras threads, a partir da vizinha.
+static bool next_tile(std::vector<TaskQueue> &queues, int self, Tile &tile, ThreadStats &stats)
+{
+    const int count = static_cast<int>(queues.size());
+    {
+        std::lock_guard<std::mutex> lock(queues[static_cast<size_t>(self)].mutex);
+        std::deque<Tile> &own = queues[static_cast<size_t>(self)].tiles;
+        if (!own.empty())
+        {
+            tile = own.back();
+            own.pop_back();
+            return true;
+        }
+    }
+
+    for (int offset = 1; offset < count; offset++)
+    {
+        TaskQueue &victim = queues[static_cast<size_t>((self + offset) % count)];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tiles.empty())
+        {
+            tile = victim.tiles.front();
+            victim.tiles.pop_front();
+            stats.steals++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Blocos tile_i x tile_j de res em ordem de linhas; cada thread recebe uma
+// faixa contígua deles, a mesma vizinhança que teria na divisão estática.
+static std::vector<TaskQueue> make_task_queues(int n, int threads, const Options &options)
+{
+    std::vector<Tile> tiles;
+    for (int ii = 0; ii < n; ii += options.tile_i)
+    {
+        for (int jj = 0; jj < n; jj += options.tile_j)
+        {
+            tiles.push_back({ii, std::min(ii + options.tile_i, n), jj, std::min(jj + options.tile_j, n)});
+        }
+    }
+
+    std::vector<TaskQueue> queues(static_cast<size_t>(threads));
+    const size_t per_thread = (tiles.size() + static_cast<size_t>(threads) - 1) / static_cast<size_t>(threads);
+    for (size_t t = 0; t < tiles.size(); t++)
+    {
+        queues[t / per_thread].tiles.push_back(tiles[t]);
+    }
+    return queues;
+}
+
+// Visão de um bloco h x h dentro de uma matriz com passo (leading dimension) ld.
+template <typename T>
+struct View
+{
+    T *data;
+    size_t ld;
+
+    T *row(int i) const
+    {
+        return data + static_cast<size_t>(i) * ld;
+    }
+
+    View quadrant(int qi, int qj, int h) const
+    {
+        return {data + static_cast<size_t>(qi) * h * ld + static_cast<size_t>(qj) * h, ld};
+    }
+};
+
+// z = x + sign * y, elemento a elemento, em blocos h x h.
+template <typename T>
+static void strassen_combine(View<T> z, View<T> x, View<T> y, int sign, int h)
+{
+    for (int i = 0; i < h; i++)
+    {
+        T *zr = z.row(i);
+        const T *xr = x.row(i);
+        const T *yr = y.row(i);
+        for (int j = 0; j < h; j++)
+        {
+            zr[j] = xr[j] + static_cast<T>(sign) * yr[j];
+        }
+    }
+}
+
+// c = p (sign == 0) ou c += sign * p.
+template <typename T>
+static void strassen_accumulate(View<T> c, View<T> p, int sign, int h)
+{
+    for (int i = 0; i < h; i++)
+    {
+        T *cr = c.row(i);
+        const T *pr = p.row(i);
+        for (int j = 0; j < h; j++)
+        {
+            cr[j] = (sign == 0) ? pr[j] : cr[j] + static_cast<T>(sign) * pr[j];
+        }
+    }
+}
+
+template <typename T>
+static void strassen_base(View<T> a, View<T> b, View<T> c, int h)
+{
+    for (int i = 0; i < h; i++)
+    {
+        T *cr = c.row(i);
+        std::fill(cr, cr + h, T(0));
+        for (int k = 0; k < h; k++)
+        {
+            const T aik = a.row(i)[k];
+            const T *br = b.row(k);
+            for (int j = 0; j < h; j++)
+            {
+                cr[j] += aik * br[j];
+            }
+        }
+    }
+}
+
+// Strassen clássico com 3 blocos temporários (S, T, P) por nível, tirados de
+// um único buffer reservado antes da recursão: cada um dos 7 produtos é
+// calculado em P e somado direto nos quadrantes de c.
+template <typename T>
+static void strassen_recursive(View<T> a, View<T> b, View<T> c, int size, int cutoff, T *work)
+{
+    if (size <= cutoff)
+    {
+        strassen_base(a, b, c, size);
+        return;
+    }
+
+    const int h = size / 2;
+    const size_t h2 = static_cast<size_t>(h) * h;
+    const View<T> s{work, static_cast<size_t>(h)};
+    const View<T> t{work + h2, static_cast<size_t>(h)};
+    const View<T> p{work + 2 * h2, static_cast<size_t>(h)};
+    T *next = work + 3 * h2;
+
+    const View a11 = a.quadrant(0, 0, h);
+    const View a12 = a.quadrant(0, 1, h);
+    const View a21 = a.quadrant(1, 0, h);
+    const View a22 = a.quadrant(1, 1, h);
+    const View b11 = b.quadrant(0, 0, h);
+    const View b12 = b.quadrant(0, 1, h);
+    const View b21 = b.quadrant(1, 0, h);
+    const View b22 = b.quadrant(1, 1, h);
+    const View c11 = c.quadrant(0, 0, h);
+    const View c12 = c.quadrant(0, 1, h);
+    const View c21 = c.quadrant(1, 0, h);
+    const View c22 = c.quadrant(1, 1, h);
+
+    // M1 = (A11 + A22)(B11 + B22)
+    strassen_combine(s, a11, a22, 1, h);
+    strassen_combine(t, b11, b22, 1, h);
+    strassen_recursive(s, t, p, h, cutoff, next);
+    strassen_accumulate(c11, p, 0, h);
+    strassen_accumulate(c22, p, 0, h);
+
+    // M2 = (A21 + A22) B11
+    strassen_combine(s, a21, a22, 1, h);
+    strassen_recursive(s, b11, p, h, cutoff, next);
+    strassen_accumulate(c21, p, 0, h);
+    strassen_accumulate(c22, p, -1, h);
+
+    // M3 = A11 (B12 - B22)
+    strassen_combine(t, b12, b22, -1, h);
+    strassen_recursive(a11, t, p, h, cutoff, next);
+    strassen_accumulate(c12, p, 0, h);
+    strassen_accumulate(c22, p, 1, h);
+
+    // M4 = A22 (B21 - B11)
+    strassen_combine(t, b21, b11, -1, h);
+    strassen_recursive(a22, t, p, h, cutoff, next);
+    strassen_accumulate(c11, p, 1, h);
+    strassen_accumulate(c21, p, 1, h);
+
+    // M5 = (A11 + A12) B22
+    strassen_combine(s, a11, a12, 1, h);
+    strassen_recursive(s, b22, p, h, cutoff, next);
+    strassen_accumulate(c11, p, -1, h);
+    strassen_accumulate(c12, p, 1, h);
+
+    // M6 = (A21 - A11)(B11 + B12)
+    strassen_combine(s, a21, a11, -1, h);
+    strassen_combine(t, b11, b12, 1, h);
+    strassen_recursive(s, t, p, h, cutoff, next);
+    strassen_accumulate(c22, p, 1, h);
+
+    // M7 = (A12 - A22)(B21 + B22)
+    strassen_combine(s, a12, a22, -1, h);
+    strassen_combine(t, b21, b22, 1, h);
+    strassen_recursive(s, t, p, h, cutoff, next);
+    strassen_accumulate(c11, p, 1, h);
+}
+
+// Menor L com ceil(n / 2^L) <= cutoff; a matriz é completada com zeros até
+// m = ceil(n / 2^L) * 2^L, que se divide ao meio exatamente L vezes. Devolve
+// os bytes temporários usados (cópias com padding + área de trabalho).
+template <typename T>
+static size_t multiply_strassen(const T *mat1, const T *mat2, T *res, int n, const Options &options)
+{
+    int levels = 0;
+    int base = n;
+    while (base > options.strassen_cutoff)
+    {
+        levels++;
+        base = (n + (1 << levels) - 1) >> levels;
+    }
+    const int m = base << levels;
+    const size_t m2 = static_cast<size_t>(m) * m;
+
+    size_t work_size = 0;
+    for (int size = m; size > base; size /= 2)
+    {
+        work_size += 3 * static_cast<size_t>(size / 2) * static_cast<size_t>(size / 2);
+    }
+
+    const bool padded = m != n;
+    std::vector<T> buffer((padded ? 3 * m2 : 0) + work_size, T(0));
+    T *work = buffer.data() + (padded ? 3 * m2 : 0);
+
+    if (!padded)
+    {
+        const size_t ld = static_cast<size_t>(n);
+        strassen_recursive<T>({const_cast<T *>(mat1), ld}, {const_cast<T *>(mat2), ld}, {res, ld}, m,
+                              options.strassen_cutoff, work);
+        return buffer.size() * sizeof(T);
+    }
+
+    T *pa = buffer.data();
+    T *pb = pa + m2;
+    T *pc = pb + m2;
+    for (int i = 0; i < n; i++)
+    {
+        const size_t src = static_cast<size_t>(i) * n;
+        std::copy(mat1 + src, mat1 + src + n, pa + static_cast<size_t>(i) * m);
+        std::copy(mat2 + src, mat2 + src + n, pb + static_cast<size_t>(i) * m);
+    }
+
+    strassen_recursive<T>({pa, static_cast<size_t>(m)}, {pb, static_cast<size_t>(m)}, {pc, static_cast<size_t>(m)}, m,
+                          options.strassen_cutoff, work);
+
+    for (int i = 0; i < n; i++)
+    {
+        const size_t src = static_cast<size_t>(i) * m;
+        std::copy(pc + src, pc + src + n, res + static_cast<size_t>(i) * n);
+    }
+    return buffer.size() * sizeof(T);
+}
+
+// Afinidade (--pin): ordem das CPUs em que as threads ficam presas, a thread
+// t em pin_cpus[t % tamanho]. compact enche os contextos SMT de um núcleo e
+// os núcleos de um nó NUMA antes de passar ao próximo; scatter alterna entre
+// os nós e só usa o segundo contexto de um núcleo depois de todos os
+// núcleos. A topologia vem de /sys, restrita às CPUs permitidas ao processo.
+struct CpuPlace
+{
+    int cpu = 0;
+    int node = 0;
+    int package = 0;
+    int core = 0;
+    int smt = 0;       // ordem entre os contextos do mesmo núcleo
+    int core_rank = 0; // ordem do núcleo dentro do nó
+};
+
+static int read_sys_int(const std::string &path, int fallback)
+{
+    std::ifstream file(path);
+    int value = fallback;
+    return (file >> value) ? value : fallback;
+}
+
+static std::vector<int> allowed_cpus()
+{
+    std::vector<int> cpus;
+#ifdef MATRIZ_AFFINITY
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty())
+    {
+        for (int cpu = 0; cpu < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+static std::vector<CpuPlace> cpu_topology(const std::vector<int> &cpus)
+{
+    const std::string sys = "/sys/devices/system/";
+    std::vector<int> node_of(65536, 0);
+    std::ifstream online(sys + "node/online");
+    std::string text;
+    if (online >> text)
+    {
+        try
+        {
+            for (int node : parse_cpu_list(text, "node/online"))
+            {
+                std::ifstream list(sys + "node/node" + std::to_string(node) + "/cpulist");
+                std::string cpulist;
+                if (list >> cpulist)
+                {
+                    for (int cpu : parse_cpu_list(cpulist, "cpulist"))
+                    {
+                        node_of[static_cast<size_t>(cpu)] = node;
+                    }
+                }
+            }
+        }
+        catch (const std::invalid_argument &)
+        {
+            std::fill(node_of.begin(), node_of.end(), 0);
+        }
+    }
+
+    std::vector<CpuPlace> places;
+    for (int cpu : cpus)
+    {
+        const std::string topology = sys + "cpu/cpu" + std::to_string(cpu) + "/topology/";
+        CpuPlace place;
+        place.cpu = cpu;
+        place.node = node_of[static_cast<size_t>(cpu)];
+        place.package = read_sys_int(topology + "physical_package_id", 0);
+        place.core = read_sys_int(topology + "core_id", cpu);
+        for (const CpuPlace &other : places)
+        {
+            place.smt += (other.package == place.package && other.core == place.core) ? 1 : 0;
+        }
+        places.push_back(place);
+    }
+
+    for (CpuPlace &place : places)
+    {
+        std::set<std::pair<int, int>> cores;
+        for (const CpuPlace &other : places)
+        {
+            if (other.node == place.node)
+            {
+                cores.insert({other.package, other.core});
+            }
+        }
+        place.core_rank = static_cast<int>(std::distance(cores.begin(), cores.find({place.package, place.core})));
+    }
+    return places;
+}
+
+// CPUs na ordem das threads para --pin; vazio com --pin none.
+std::vector<int> pin_layout(const Options &options)
+{
+    const std::vector<int> allowed = allowed_cpus();
+    if (options.pin == Pin::None)
+    {
+        return {};
+    }
+    if (options.pin == Pin::List)
+    {
+        for (int cpu : options.pin_cpus)
+        {
+            if (std::find(allowed.begin(), allowed.end(), cpu) == allowed.end())
+            {
+                throw std::invalid_argument("CPU " + std::to_string(cpu) + " de --pin fora das CPUs permitidas");
+            }
+        }
+        return options.pin_cpus;
+    }
+
+    std::vector<CpuPlace> places = cpu_topology(allowed);
+    std::sort(places.begin(), places.end(), [&](const CpuPlace &a, const CpuPlace &b) {
+        if (options.pin == Pin::Compact)
+        {
+            return std::make_tuple(a.node, a.package, a.core, a.smt) <
+                   std::make_tuple(b.node, b.package, b.core, b.smt);
+        }
+        return std::make_tuple(a.smt, a.core_rank, a.node, a.cpu) < std::make_tuple(b.smt, b.core_rank, b.node, b.cpu);
+    });
+    std::vector<int> layout;
+    for (const CpuPlace &place : places)
+    {
+        layout.push_back(place.cpu);
+    }
+    return layout;
+}
+
+// Nó NUMA de cada CPU do layout, para os metadados.
+static std::vector<int> pin_nodes(const std::vector<int> &layout)
+{
+    std::vector<int> nodes;
+    for (const CpuPlace &place : cpu_topology(layout))
+    {
+        nodes.push_back(place.node);
+    }
+    return nodes;
+}
+
+// Prende a thread que chama à CPU da thread lógica `thread`.
+void pin_thread(const Options &options, int thread)
+{
+#ifdef MATRIZ_AFFINITY
+    if (options.pin_cpus.empty())
+    {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(options.pin_cpus[static_cast<size_t>(thread) % options.pin_cpus.size()], &set);
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)options;
+    (void)thread;
+#endif
+}
+
+// Roda work(t) para t = 0..threads-1: direto na thread principal com uma
+// thread, senão em threads novas, cada uma presa conforme --pin.
+static void run_parallel(int threads, const Options &options, const std::function<void(int)> &work)
+{
+    if (threads == 1)
+    {
+        work(0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<size_t>(threads));
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            pin_thread(options, t);
+            work(t);
+        });
+    }
+    for (std::thread &thread : workers)
+    {
+        thread.join();
+    }
+}
+
+// Blocos de res de cada thread do kernel: a faixa de linhas do escalonamento
+// estático ou a fila inicial do steal (antes de qualquer roubo). Strassen
+// roda inteiro na thread principal.
+static std::vector<std::vector<Tile>> owned_tiles(int n, const Options &options)
+{
+    const int threads = options.kernel == Kernel::Strassen ? 1 : std::max(1, options.threads);
+    std::vector<std::vector<Tile>> owned(static_cast<size_t>(threads));
+    if (options.schedule == Schedule::Steal && threads > 1)
+    {
+        std::vector<TaskQueue> queues = make_task_queues(n, threads, options);
+        for (int t = 0; t < threads; t++)
+        {
+            owned[static_cast<size_t>(t)].assign(queues[static_cast<size_t>(t)].tiles.begin(),
+                                                 queues[static_cast<size_t>(t)].tiles.end());
+        }
+        return owned;
+    }
+    const int chunk = (n + threads - 1) / threads;
+    for (int t = 0; t < threads; t++)
+    {
+        const int row_begin = std::min(t * chunk, n);
+        if (row_begin < std::min(row_begin + chunk, n))
+        {
+            owned[static_cast<size_t>(t)].push_back({row_begin, std::min(row_begin + chunk, n), 0, n});
+        }
+    }
+    return owned;
+}
+
+// Soma em stats os contadores de uma região paralela de wall segundos; ocioso
+// é wall menos o tempo ocupado de cada thread.
+static void add_thread_stats(std::vector<ThreadStats> *stats, const std::vector<ThreadStats> &local, double wall)
+{
+    if (stats == nullptr)
+    {
+        return;
+    }
+    stats->resize(local.size());
+    for (size_t t = 0; t < local.size(); t++)
+    {
+        (*stats)[t].tasks += local[t].tasks;
+        (*stats)[t].steals += local[t].steals;
+        (*stats)[t].busy += local[t].busy;
+        (*stats)[t].pack += local[t].pack;
+        (*stats)[t].idle += std::max(0.0, wall - local[t].busy);
+    }
+}
+
+// Layout Morton (--kernel morton): a matriz, completada com zeros até
+// m = b * 2^L (L escolhido como no Strassen, com folhas b <= kMortonLeaf),
+// vira 4^L blocos b x b, cada um contíguo por linhas, em ordem Z. Em todo
+// nível da recursão os quatro quadrantes (00, 01, 10, 11) são trechos
+// contíguos, então o produto recursivo cabe em cada nível de cache sem
+// conhecer o tamanho de nenhum: não há blocos para ajustar por máquina. A
+// folha só precisa caber no L1 de qualquer CPU (3 x 32 x 32 doubles = 24 KiB).
+static const int kMortonLeaf = 32;
+
+struct MortonLayout
+{
+    int n = 0;
+    int leaf = 0;   // b: lado de um bloco folha
+    int blocks = 0; // 2^L: blocos por lado
+
+    size_t elements() const
+    {
+        const size_t side = static_cast<size_t>(leaf) * static_cast<size_t>(blocks);
+        return side * side;
+    }
+};
+
+static MortonLayout morton_layout(int n)
+{
+    int levels = 0;
+    int base = n;
+    while (base > kMortonLeaf)
+    {
+        levels++;
+        base = (n + (1 << levels) - 1) >> levels;
+    }
+    MortonLayout layout;
+    layout.n = n;
+    layout.leaf = base;
+    layout.blocks = 1 << levels;
+    return layout;
+}
+
+// Posição do bloco (bi, bj) na ordem Z: bits de bi e bj intercalados, o de
+// bi como o mais alto de cada par.
+static size_t morton_index(int bi, int bj)
+{
+    size_t z = 0;
+    for (int bit = 0; (bi >> bit) != 0 || (bj >> bit) != 0; bit++)
+    {
+        z |= static_cast<size_t>((bi >> bit) & 1) << (2 * bit + 1);
+        z |= static_cast<size_t>((bj >> bit) & 1) << (2 * bit);
+    }
+    return z;
+}
+
+// src (n x n por linhas) para dst no layout Morton, com zeros no padding.
+template <typename T>
+static void to_morton(const T *src, T *dst, const MortonLayout &layout)
+{
+    const int b = layout.leaf;
+    const int n = layout.n;
+    const size_t b2 = static_cast<size_t>(b) * b;
+    for (int bi = 0; bi < layout.blocks; bi++)
+    {
+        for (int bj = 0; bj < layout.blocks; bj++)
+        {
+            T *block = dst + morton_index(bi, bj) * b2;
+            const int j0 = bj * b;
+            for (int r = 0; r < b; r++)
+            {
+                const int i = bi * b + r;
+                const int count = i < n ? std::max(0, std::min(b, n - j0)) : 0;
+                T *out = block + static_cast<size_t>(r) * b;
+                const T *in = src + static_cast<size_t>(i) * n + j0;
+                std::copy(in, in + count, out);
+                std::fill(out + count, out + b, T(0));
+            }
+        }
+    }
+}
+
+// Volta do layout Morton para dst (n x n por linhas), descartando o padding.
+template <typename T>
+static void from_morton(const T *src, T *dst, const MortonLayout &layout)
+{
+    const int b = layout.leaf;
+    const int n = layout.n;
+    const size_t b2 = static_cast<size_t>(b) * b;
+    for (int bi = 0; bi * b < n; bi++)
+    {
+        for (int bj = 0; bj * b < n; bj++)
+        {
+            const T *block = src + morton_index(bi, bj) * b2;
+            const int j0 = bj * b;
+            const int count = std::min(b, n - j0);
+            for (int r = 0; r < b && bi * b + r < n; r++)
+            {
+                const T *in = block + static_cast<size_t>(r) * b;
+                std::copy(in, in + count, dst + static_cast<size_t>(bi * b + r) * n + j0);
+            }
+        }
+    }
+}
+
+// c += a x b em blocos folha contíguos, ordem i-k-j.
+template <typename T>
+static void morton_leaf(const T *a, const T *b, T *c, int leaf)
+{
+    for (int i = 0; i < leaf; i++)
+    {
+        T *cr = c + static_cast<size_t>(i) * leaf;
+        for (int k = 0; k < leaf; k++)
+        {
+            const T aik = a[static_cast<size_t>(i) * leaf + k];
+            const T *br = b + static_cast<size_t>(k) * leaf;
+            for (int j = 0; j < leaf; j++)
+            {
+                cr[j] += aik * br[j];
+            }
+        }
+    }
+}
+
+// c += a x b com a, b e c submatrizes Morton de blocks x blocks folhas:
+// oito produtos de quadrantes, cada um outra submatriz Morton contígua.
+template <typename T>
+static void morton_recursive(const T *a, const T *b, T *c, int blocks, int leaf)
+{
+    if (blocks == 1)
+    {
+        morton_leaf(a, b, c, leaf);
+        return;
+    }
+    const int half = blocks / 2;
+    const size_t quadrant = static_cast<size_t>(half) * half * leaf * leaf;
+    for (int i = 0; i < 2; i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            for (int k = 0; k < 2; k++)
+            {
+                morton_recursive(a + (2 * i + k) * quadrant, b + (2 * k + j) * quadrant, c + (2 * i + j) * quadrant,
+                                 half, leaf);
+            }
+        }
+    }
+}
+
+// res = mat1 x mat2 pelo layout Morton. Com T threads, res é cortada no
+// menor nível d com 4^d >= T e a thread t calcula os sub-blocos t, t + T,
+// ... (cada um uma soma de produtos recursivos independente). As conversões
+// (entrada e saída, em uma thread) são somadas em *time_convert quando
+// não nulo. Devolve os bytes das três cópias Morton.
+template <typename T>
+static size_t multiply_morton(const T *mat1, const T *mat2, T *res, int n, const Options &options,
+                              std::vector<ThreadStats> *stats, double *time_convert)
+{
+    const MortonLayout layout = morton_layout(n);
+    const size_t m2 = layout.elements();
+
+    // Alocação sem inicialização: to_morton escreve todo a e b (padding
+    // incluído), então só c precisa ser zerada, também dentro da conversão.
+    auto start = Clock::now();
+    std::unique_ptr<T[]> buffer(new T[3 * m2]);
+    T *a = buffer.get();
+    T *b = a + m2;
+    T *c = b + m2;
+    to_morton(mat1, a, layout);
+    to_morton(mat2, b, layout);
+    std::fill(c, c + m2, T(0));
+    double convert = elapsed_seconds(start, Clock::now());
+
+    const int threads = std::max(1, options.threads);
+    int depth = 0;
+    while ((1 << (2 * depth)) < threads && (layout.blocks >> depth) > 1)
+    {
+        depth++;
+    }
+    const int side = 1 << depth;
+    const int sub = layout.blocks >> depth;
+    const size_t sub_elements = static_cast<size_t>(sub) * sub * layout.leaf * layout.leaf;
+    std::vector<ThreadStats> local(static_cast<size_t>(threads));
+
+    start = Clock::now();
+    run_parallel(threads, options, [&](int self) {
+        ThreadStats &mine = local[static_cast<size_t>(self)];
+        for (int task = self; task < side * side; task += threads)
+        {
+            const auto task_start = Clock::now();
+            const int ci = task / side;
+            const int cj = task % side;
+            T *c_sub = c + morton_index(ci, cj) * sub_elements;
+            for (int k = 0; k < side; k++)
+            {
+                morton_recursive(a + morton_index(ci, k) * sub_elements, b + morton_index(k, cj) * sub_elements,
+                                 c_sub, sub, layout.leaf);
+            }
+            mine.busy += elapsed_seconds(task_start, Clock::now());
+            mine.tasks++;
+        }
+    });
+    add_thread_stats(stats, local, elapsed_seconds(start, Clock::now()));
+
+    start = Clock::now();
+    from_morton(c, res, layout);
+    convert += elapsed_seconds(start, Clock::now());
+    if (time_convert != nullptr)
+    {
+        *time_convert += convert;
+    }
+    return 3 * m2 * sizeof(T);
+}
+
+// res = mat1 x mat2 pelo kernel packed. Para cada painel (jc, pc), as
+// threads empacotam juntas B[KC x NC] em um único buffer compartilhado (cada
+// uma um trecho de micro-painéis) e depois dividem os blocos ic de MC
+// linhas: cada thread empacota o próprio A[MC x KC] em um buffer seu,
+// reaproveitado entre blocos, e roda o micro-kernel contra o B comum. Com
+// T threads, MC é limitado a ceil(N / T) para que todas recebam blocos. No
+// escalonamento estático a thread t fica com a t-ésima faixa contígua de
+// blocos; com steal, os blocos de cada painel vão para as filas com roubo.
+// O tempo de empacotamento vai para ThreadStats::pack. Devolve os bytes dos
+// buffers empacotados.
+template <typename T>
+static size_t multiply_packed(const T *mat1, const T *mat2, T *res, int n, const Options &options,
+                              std::vector<ThreadStats> *stats)
+{
+    const PackedMicro<T> micro = packed_micro<T>(options.isa);
+    PackedBlocking block = packed_blocking(micro.nr, sizeof(T), options);
+    const int threads = std::max(1, options.threads);
+    const int share = (n + threads - 1) / threads;
+    block.mc = std::max(1, std::min(block.mc, (share + kPackedMr - 1) / kPackedMr * kPackedMr));
+    const int nc_max = std::min(block.nc, n);
+    const int kc_max = std::min(block.kc, n);
+    const size_t a_size = static_cast<size_t>((block.mc + kPackedMr - 1) / kPackedMr * kPackedMr) * kc_max;
+    const int b_panels = (nc_max + micro.nr - 1) / micro.nr;
+    std::vector<T> b_packed(static_cast<size_t>(b_panels) * micro.nr * kc_max);
+    std::vector<std::vector<T>> a_packed(static_cast<size_t>(threads), std::vector<T>(a_size));
+    std::vector<ThreadStats> local(static_cast<size_t>(threads));
+    double wall = 0.0;
+
+    for (int jc = 0; jc < n; jc += block.nc)
+    {
+        const int nc = std::min(block.nc, n - jc);
+        const int panels = (nc + micro.nr - 1) / micro.nr;
+        for (int pc = 0; pc < n; pc += block.kc)
+        {
+            const int kc = std::min(block.kc, n - pc);
+
+            auto start = Clock::now();
+            run_parallel(threads, options, [&](int self) {
+                const int chunk = (panels + threads - 1) / threads;
+                const int first = std::min(self * chunk, panels) * micro.nr;
+                const int last = std::min((self + 1) * chunk * micro.nr, nc);
+                if (first < last)
+                {
+                    const auto pack_start = Clock::now();
+                    pack_b(mat2, n, pc, kc, jc + first, last - first, micro.nr,
+                           b_packed.data() + static_cast<size_t>(first) * kc);
+                    const double elapsed = elapsed_seconds(pack_start, Clock::now());
+                    local[static_cast<size_t>(self)].pack += elapsed;
+                    local[static_cast<size_t>(self)].busy += elapsed;
+                }
+            });
+
+            // Blocos ic deste painel; o primeiro painel de k também zera res.
+            const auto compute = [&](const Tile &tile, int self) {
+                ThreadStats &mine = local[static_cast<size_t>(self)];
+                const auto tile_start = Clock::now();
+                const int ic = tile.row_begin;
+                const int mc = tile.row_end - tile.row_begin;
+                if (pc == 0)
+                {
+                    clear_tile(res, n, tile);
+                }
+                T *a = a_packed[static_cast<size_t>(self)].data();
+                pack_a(mat1, n, ic, mc, pc, kc, a);
+                mine.pack += elapsed_seconds(tile_start, Clock::now());
+                for (int jr = 0; jr < nc; jr += micro.nr)
+                {
+                    const T *b_panel = b_packed.data() + static_cast<size_t>(jr) * kc;
+                    for (int ir = 0; ir < mc; ir += kPackedMr)
+                    {
+                        micro.run(kc, a + static_cast<size_t>(ir) * kc, b_panel,
+                                  res + static_cast<size_t>(ic + ir) * n + jc + jr, static_cast<size_t>(n),
+                                  std::min(kPackedMr, mc - ir), std::min(micro.nr, nc - jr));
+                    }
+                }
+                mine.busy += elapsed_seconds(tile_start, Clock::now());
+                mine.tasks++;
+            };
+
+            std::vector<Tile> tiles;
+            for (int ic = 0; ic < n; ic += block.mc)
+            {
+                tiles.push_back({ic, std::min(ic + block.mc, n), jc, jc + nc});
+            }
+            if (options.schedule == Schedule::Steal && threads > 1)
+            {
+                std::vector<TaskQueue> queues(static_cast<size_t>(threads));
+                const size_t per_thread =
+                    (tiles.size() + static_cast<size_t>(threads) - 1) / static_cast<size_t>(threads);
+                for (size_t t = 0; t < tiles.size(); t++)
+                {
+                    queues[t / per_thread].tiles.push_back(tiles[t]);
+                }
+                run_parallel(threads, options, [&](int self) {
+                    ThreadStats &mine = local[static_cast<size_t>(self)];
+                    Tile tile{};
+                    while (next_tile(queues, self, tile, mine))
+                    {
+                        compute(tile, self);
+                    }
+                });
+            }
+            else
+            {
+                run_parallel(threads, options, [&](int self) {
+                    const size_t chunk =
+                        (tiles.size() + static_cast<size_t>(threads) - 1) / static_cast<size_t>(threads);
+                    const size_t begin = static_cast<size_t>(self) * chunk;
+                    const size_t end = std::min(tiles.size(), begin + chunk);
+                    for (size_t t = begin; t < end; t++)
+                    {
+                        compute(tiles[t], self);
+                    }
+                });
+            }
+            wall += elapsed_seconds(start, Clock::now());
+        }
+    }
+    add_thread_stats(stats, local, wall);
+    return (b_packed.size() + a_size * static_cast<size_t>(threads)) * sizeof(T);
+}
+
+#ifdef MATRIZ_BLAS
+// Biblioteca BLAS ligada, para o --meta-json e a mensagem inicial.
+std::string blas_library()
+{
+    if (openblas_get_config != nullptr)
+    {
+        return openblas_get_config();
+    }
+    if (bli_info_get_version_str != nullptr)
+    {
+        return std::string("BLIS ") + bli_info_get_version_str();
+    }
+    return "CBLAS";
+}
+
+// res = mat1 x mat2 com ?gemm da biblioteca, que usa --threads threads
+// próprias (sem --schedule nem --pin).
+template <typename T>
+static void multiply_blas(const T *mat1, const T *mat2, T *res, int n, const Options &options)
+{
+    const int threads = std::max(1, options.threads);
+    if (openblas_set_num_threads != nullptr)
+    {
+        openblas_set_num_threads(threads);
+    }
+    else if (bli_thread_set_num_threads != nullptr)
+    {
+        bli_thread_set_num_threads(threads);
+    }
+
+    if constexpr (std::is_same<T, float>::value)
+    {
+        cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, 1.0f, mat1, n, mat2, n, 0.0f, res, n);
+    }
+    else if constexpr (std::is_same<T, double>::value)
+    {
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, 1.0, mat1, n, mat2, n, 0.0, res, n);
+    }
+    else
+    {
+        check_blas(Kernel::Blas, DType::Int32);
+    }
+}
+#endif
+
+// Com uma thread, roda direto na thread principal. Com mais, o escalonamento
+// estático dá à thread t o t-ésimo bloco contíguo de ceil(n / threads)
+// linhas; o escalonamento steal distribui blocos 2-D com roubo de tarefas.
+// Ocioso é o tempo de parede da região paralela menos o tempo ocupado.
+// Strassen roda sempre inteiro na thread principal, blas com as threads
+// da biblioteca, morton e packed com a própria divisão. Devolve os bytes
+// temporários alocados pelo kernel (0 para os kernels em blocos); o tempo
+// de conversão de layout do morton vai para *time_convert.
+template <typename T>
+static size_t run_kernel(const T *mat1, const T *mat2, T *res, int n, const Options &options,
+                         std::vector<ThreadStats> *stats, double *time_convert = nullptr)
+{
+    if (options.kernel == Kernel::Strassen)
+    {
+        return multiply_strassen(mat1, mat2, res, n, options);
+    }
+    if (options.kernel == Kernel::Morton)
+    {
+        return multiply_morton(mat1, mat2, res, n, options, stats, time_convert);
+    }
+    if (options.kernel == Kernel::Packed)
+    {
+        return multiply_packed(mat1, mat2, res, n, options, stats);
+    }
+    if (options.kernel == Kernel::Blas)
+    {
+#ifdef MATRIZ_BLAS
+        multiply_blas(mat1, mat2, res, n, options);
+#else
+        check_blas(Kernel::Blas, options.dtype);
+#endif
+        return 0;
+    }
+
+    const int threads = std::max(1, options.threads);
+    std::vector<ThreadStats> local(static_cast<size_t>(threads));
+    std::vector<TaskQueue> queues;
+    std::function<void(int)> worker;
+
+    if (options.schedule == Schedule::Steal)
+    {
+        queues = make_task_queues(n, threads, options);
+        worker = [&](int self) {
+            ThreadStats &mine = local[static_cast<size_t>(self)];
+            Tile tile{};
+            while (next_tile(queues, self, tile, mine))
+            {
+                const auto start = Clock::now();
+                run_tile(mat1, mat2, res, n, tile, options);
+                mine.busy += elapsed_seconds(start, Clock::now());
+                mine.tasks++;
+            }
+        };
+    }
+    else
+    {
+        const int chunk = (n + threads - 1) / threads;
+        worker = [&, chunk](int self) {
+            const int row_begin = std::min(self * chunk, n);
+            const Tile tile{row_begin, std::min(row_begin + chunk, n), 0, n};
+            if (tile.row_begin < tile.row_end)
+            {
+                const auto start = Clock::now();
+                run_tile(mat1, mat2, res, n, tile, options);
+                local[static_cast<size_t>(self)].busy += elapsed_seconds(start, Clock::now());
+                local[static_cast<size_t>(self)].tasks++;
+            }
+        };
+    }
+
+    const auto start = Clock::now();
+    run_parallel(threads, options, worker);
+    add_thread_stats(stats, local, elapsed_seconds(start, Clock::now()));
+
+    return 0;
+}
+
+// Inteiros precisam bater exatamente; ponto flutuante aceita o erro de
+// arredondamento de uma soma de N produtos (N * epsilon, relativo).
+template <typename T>
+static bool matches(T value, double expected, int n)
+{
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        const double tolerance = static_cast<double>(n) * std::numeric_limits<T>::epsilon();
+        return std::fabs(static_cast<double>(value) - expected) <= tolerance * std::max(1.0, std::fabs(expected));
+    }
+    else
+    {
+        return static_cast<double>(value) == expected;
+    }
+}
+
+template <typename T>
+static bool verify_sample(const T *res, int n)
+{
+    const int idxs[3] = {0, n / 2, n - 1};
+
+    for (int i : idxs)
+    {
+        for (int j : idxs)
+        {
+            if (!matches(res[static_cast<size_t>(i) * n + j], static_cast<double>(i + j), n))
+            {
+                std::cerr << "Erro na multiplicacao para N=" << n << " em [" << i << "," << j << "]\n";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// splitmix64: determinístico pela semente e idêntico em qualquer plataforma
+// (as distribuições de <random> não garantem a mesma sequência).
+class SplitMix64
+{
+public:
+    explicit SplitMix64(std::uint64_t seed) : state_(seed) {}
+
+    std::uint64_t next()
+    {
+        std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    // Avança count números sem gerá-los.
+    void skip(std::uint64_t count)
+    {
+        state_ += count * 0x9e3779b97f4a7c15ULL;
+    }
+
+    // Uniforme em [-1, 1).
+    double uniform()
+    {
+        return static_cast<double>(next() >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+    }
+
+private:
+    std::uint64_t state_;
+};
+
+// Entradas conforme --input: identity preenche mat1[i][j] = i + j e mat2 com
+// a identidade (o padrão histórico, conferido por verify_sample); random usa
+// inteiros em [-8, 8] ou reais em [-1, 1) a partir de --seed, pequenos o
+// bastante para a soma de N produtos não estourar int32 até N = 100000.
+// fill_tile preenche só uma região; o gerador salta até o início de cada
+// linha, então os valores independem de quem preenche cada região.
+template <typename T>
+static void fill_tile(T *mat1, T *mat2, int n, const Tile &tile, const Options &options)
+{
+    for (int i = tile.row_begin; i < tile.row_end; i++)
+    {
+        SplitMix64 rng(options.seed);
+        rng.skip(2 * (static_cast<std::uint64_t>(i) * n + tile.col_begin));
+        for (int j = tile.col_begin; j < tile.col_end; j++)
+        {
+            const size_t idx = static_cast<size_t>(i) * n + j;
+            if (options.input == Input::Identity)
+            {
+                mat1[idx] = static_cast<T>(i + j);
+                mat2[idx] = (i == j) ? T(1) : T(0);
+            }
+            else if constexpr (std::is_floating_point<T>::value)
+            {
+                mat1[idx] = static_cast<T>(rng.uniform());
+                mat2[idx] = static_cast<T>(rng.uniform());
+            }
+            else
+            {
+                mat1[idx] = static_cast<T>(static_cast<int>(rng.next() % 17) - 8);
+                mat2[idx] = static_cast<T>(static_cast<int>(rng.next() % 17) - 8);
+            }
+        }
+    }
+}
+
+template <typename T>
+static void fill_inputs(T *mat1, T *mat2, int n, const Options &options)
+{
+    fill_tile(mat1, mat2, n, Tile{0, n, 0, n}, options);
+}
+
+// Primeiro toque paralelo (--init parallel): cada thread, presa à mesma CPU
+// que terá no kernel, zera os blocos de res que vai calcular e preenche os
+// mesmos trechos de mat1 e mat2. Assim as páginas ficam no nó NUMA de quem
+// as usa, em vez de todas no nó da thread principal. Com fill falso, mat1 e
+// mat2 também só são zeradas, e o preenchimento fica para depois.
+template <typename T>
+static void first_touch(T *mat1, T *mat2, T *res, int n, const Options &options, bool fill)
+{
+    const std::vector<std::vector<Tile>> owned = owned_tiles(n, options);
+    run_parallel(static_cast<int>(owned.size()), options, [&](int self) {
+        for (const Tile &tile : owned[static_cast<size_t>(self)])
+        {
+            if (fill)
+            {
+                fill_tile(mat1, mat2, n, tile, options);
+            }
+            for (int i = tile.row_begin; i < tile.row_end; i++)
+            {
+                const size_t row = static_cast<size_t>(i) * n;
+                std::fill(res + row + tile.col_begin, res + row + tile.col_end, T(0));
+                if (!fill)
+                {
+                    std::fill(mat1 + row + tile.col_begin, mat1 + row + tile.col_end, T(0));
+                    std::fill(mat2 + row + tile.col_begin, mat2 + row + tile.col_end, T(0));
+                }
+            }
+        }
+    });
+}
+
+// Teste de Freivalds: confere res inteiro comparando mat1 (mat2 r) com res r
+// em O(N^2). Para inteiros, r tem 64 bits aleatórios e as contas são módulo
+// 2^64, então um res errado passa com probabilidade desprezível. Para
+// ponto flutuante, r fica em [-1, 1) e cada linha aceita o erro de
+// arredondamento 2 N epsilon (|mat1| (|mat2| |r|)).
+template <typename T>
+static bool freivalds(const T *mat1, const T *mat2, const T *res, int n, std::uint64_t seed)
+{
+    const size_t size = static_cast<size_t>(n);
+    SplitMix64 rng(seed ^ 0x5851f42d4c957f2dULL);
+
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        std::vector<double> r(size);
+        std::vector<double> br(size, 0.0);
+        std::vector<double> br_abs(size, 0.0);
+        for (double &value : r)
+        {
+            value = rng.uniform();
+        }
+        for (size_t i = 0; i < size; i++)
+        {
+            const T *row = mat2 + i * size;
+            for (size_t j = 0; j < size; j++)
+            {
+                br[i] += static_cast<double>(row[j]) * r[j];
+                br_abs[i] += std::fabs(static_cast<double>(row[j]) * r[j]);
+            }
+        }
+        const double epsilon = static_cast<double>(std::numeric_limits<T>::epsilon());
+        for (size_t i = 0; i < size; i++)
+        {
+            double abr = 0.0;
+            double bound = 0.0;
+            double cr = 0.0;
+            for (size_t j = 0; j < size; j++)
+            {
+                abr += static_cast<double>(mat1[i * size + j]) * br[j];
+                bound += std::fabs(static_cast<double>(mat1[i * size + j])) * br_abs[j];
+                cr += static_cast<double>(res[i * size + j]) * r[j];
+            }
+            if (std::fabs(abr - cr) > 2.0 * static_cast<double>(n) * epsilon * bound + 1e-300)
+            {
+                std::cerr << "Erro na multiplicacao para N=" << n << ": Freivalds falhou na linha " << i << "\n";
+                return false;
+            }
+        }
+    }
+    else
+    {
+        auto wrap = [](T value) { return static_cast<std::uint64_t>(static_cast<std::int64_t>(value)); };
+        std::vector<std::uint64_t> r(size);
+        std::vector<std::uint64_t> br(size, 0);
+        for (std::uint64_t &value : r)
+        {
+            value = rng.next();
+        }
+        for (size_t i = 0; i < size; i++)
+        {
+            const T *row = mat2 + i * size;
+            for (size_t j = 0; j < size; j++)
+            {
+                br[i] += wrap(row[j]) * r[j];
+            }
+        }
+        for (size_t i = 0; i < size; i++)
+        {
+            std::uint64_t abr = 0;
+            std::uint64_t cr = 0;
+            for (size_t j = 0; j < size; j++)
+            {
+                abr += wrap(mat1[i * size + j]) * br[j];
+                cr += wrap(res[i * size + j]) * r[j];
+            }
+            if (abr != cr)
+            {
+                std::cerr << "Erro na multiplicacao para N=" << n << ": Freivalds falhou na linha " << i << "\n";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Contadores de hardware (--perf-stats), lidos com perf_event_open em torno
+// do kernel. Cada evento é aberto sozinho, com inherit para somar as threads
+// de trabalho criadas depois; os que o sistema recusar (perf_event_paranoid,
+// contêineres, VMs sem PMU) ficam N/A sem interromper a medição. RESET só
+// zera a contagem da thread principal, não a já herdada de threads que
+// terminaram, então cada medição é a diferença entre leituras em start() e
+// stop().
+static const int kPerfEvents = 5;
+static const char *const kPerfNames[kPerfEvents] = {"ciclos", "instrucoes", "falhas L1D", "falhas LLC",
+                                                    "falhas dTLB"};
+
+class PerfCounters
+{
+public:
+    ~PerfCounters()
+    {
+#ifdef MATRIZ_PERF
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    // Abre os eventos e devolve quantos ficaram disponíveis.
+    int open()
+    {
+        int opened = 0;
+#ifdef MATRIZ_PERF
+        const std::uint64_t read_miss =
+            (static_cast<std::uint64_t>(PERF_COUNT_HW_CACHE_OP_READ) << 8) |
+            (static_cast<std::uint64_t>(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+        const std::uint32_t types[kPerfEvents] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+                                                  PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE};
+        const std::uint64_t configs[kPerfEvents] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                    PERF_COUNT_HW_CACHE_L1D | read_miss,
+                                                    PERF_COUNT_HW_CACHE_LL | read_miss,
+                                                    PERF_COUNT_HW_CACHE_DTLB | read_miss};
+
+        for (int e = 0; e < kPerfEvents; e++)
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = types[e];
+            attr.config = configs[e];
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[e] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds_[e] >= 0)
+            {
+                opened++;
+            }
+        }
+#endif
+        active_ = opened > 0;
+        return opened;
+    }
+
+    bool active() const
+    {
+        return active_;
+    }
+
+    bool available(int event) const
+    {
+        return fds_[event] >= 0;
+    }
+
+    void start()
+    {
+#ifdef MATRIZ_PERF
+        for (int e = 0; e < kPerfEvents; e++)
+        {
+            if (fds_[e] >= 0 && !read_event(e, base_[e]))
+            {
+                std::fill(base_[e], base_[e] + 3, 0);
+            }
+        }
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Soma em totals as contagens desde start(), corrigidas pela fração de
+    // tempo em que o evento esteve de fato no PMU (multiplexação).
+    void stop(double *totals)
+    {
+#ifdef MATRIZ_PERF
+        for (int e = 0; e < kPerfEvents; e++)
+        {
+            if (fds_[e] < 0)
+            {
+                continue;
+            }
+            ioctl(fds_[e], PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t values[3] = {0, 0, 0};
+            if (!read_event(e, values))
+            {
+                continue;
+            }
+            const std::uint64_t count = values[0] - base_[e][0];
+            const std::uint64_t enabled = values[1] - base_[e][1];
+            const std::uint64_t running = values[2] - base_[e][2];
+            if (running > 0)
+            {
+                totals[e] += static_cast<double>(count) * static_cast<double>(enabled) / static_cast<double>(running);
+            }
+        }
+#else
+        (void)totals;
+#endif
+    }
+
+private:
+#ifdef MATRIZ_PERF
+    // Contagem, tempo habilitado e tempo no PMU, somados às threads herdadas.
+    bool read_event(int event, std::uint64_t *values) const
+    {
+        return read(fds_[event], values, 3 * sizeof(std::uint64_t)) ==
+               static_cast<ssize_t>(3 * sizeof(std::uint64_t));
+    }
+#endif
+
+    int fds_[kPerfEvents] = {-1, -1, -1, -1, -1};
+    std::uint64_t base_[kPerfEvents][3] = {};
+    bool active_ = false;
+};
+
+static PerfCounters g_perf;
+
+// Abre os contadores de --perf-stats e avisa na inicialização os que o
+// sistema recusou (gravados como N/A).
+void open_perf_counters()
+{
+    if (g_perf.open() == 0)
+    {
+        std::cout << "Contadores de hardware indisponiveis (perf_event_open recusado; veja "
+                     "/proc/sys/kernel/perf_event_paranoid); colunas gravadas como N/A.\n";
+    }
+    for (int e = 0; g_perf.active() && e < kPerfEvents; e++)
+    {
+        if (!g_perf.available(e))
+        {
+            std::cout << "Contador de " << kPerfNames[e] << " indisponivel; gravado como N/A.\n";
+        }
+    }
+}
+
+// Memória por fase (--mem-stats): faltas de página menores e maiores do
+// processo inteiro (getrusage, soma todas as threads) e pico de RSS de
+// /proc/self/status. No início de cada fase o pico (VmHWM) é zerado com
+// "5" em /proc/self/clear_refs, então o VmHWM do fim é o pico da própria
+// fase; se o kernel recusar, vale o maior RSS lido nas bordas da fase (um
+// limite inferior). As leituras ficam fora das janelas cronometradas.
+// Fases: 0 = alocação e preenchimento (TAM), 1 = produto (TCS),
+// 2 = liberação (TDM).
+static const int kMemPhases = 3;
+
+struct MemStats
+{
+    double rss_peak[kMemPhases] = {};     // bytes; máximo entre as repetições
+    double minor_faults[kMemPhases] = {}; // médias por repetição
+    double major_faults[kMemPhases] = {};
+};
+
+// Contadores no início de uma fase.
+struct MemMark
+{
+    long minor_faults = 0;
+    long major_faults = 0;
+    double rss = 0.0;
+    bool peak_reset = false;
+};
+
+// VmRSS e VmHWM de /proc/self/status, em bytes (0 se ausentes).
+static void read_rss(double &rss, double &peak)
+{
+    rss = 0.0;
+    peak = 0.0;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmRSS:") == 0)
+        {
+            rss = std::strtod(line.c_str() + 6, nullptr) * 1024.0;
+        }
+        else if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            peak = std::strtod(line.c_str() + 6, nullptr) * 1024.0;
+        }
+    }
+}
+
+static void mem_begin(const Options &options, MemMark &mark)
+{
+    if (!options.mem_stats)
+    {
+        return;
+    }
+#ifdef MATRIZ_RUSAGE
+    double peak = 0.0;
+    read_rss(mark.rss, peak);
+    const int fd = open("/proc/self/clear_refs", O_WRONLY);
+    mark.peak_reset = fd >= 0 && write(fd, "5", 1) == 1;
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    mark.minor_faults = usage.ru_minflt;
+    mark.major_faults = usage.ru_majflt;
+#endif
+}
+
+static void mem_end(const Options &options, const MemMark &mark, MemStats &stats, int phase)
+{
+    if (!options.mem_stats)
+    {
+        return;
+    }
+#ifdef MATRIZ_RUSAGE
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    double rss = 0.0;
+    double peak = 0.0;
+    read_rss(rss, peak);
+    if (!mark.peak_reset)
+    {
+        peak = std::max(mark.rss, rss);
+    }
+    stats.rss_peak[phase] = std::max(stats.rss_peak[phase], peak);
+    stats.minor_faults[phase] += static_cast<double>(usage.ru_minflt - mark.minor_faults);
+    stats.major_faults[phase] += static_cast<double>(usage.ru_majflt - mark.major_faults);
+#else
+    (void)mark;
+    (void)stats;
+    (void)phase;
+#endif
+}
+
+// Tempos e volume de E/S do motor fora do núcleo (--ooc).
+struct OocStats
+{
+    double time_io = 0.0;
+    double time_compute = 0.0;
+    double time_wait = 0.0;
+    double io_bytes = 0.0;
+    size_t work_bytes = 0;
+};
+
+// Somas (e, em run_point, médias) das repetições de um ponto da varredura.
+struct PointResult
+{
+    double time_alloc = 0.0;
+    double time_calc = 0.0;
+    double time_free = 0.0;
+    // Custo da verificação de Freivalds, fora de TCS.
+    double time_verify = 0.0;
+    // Conversões de e para o layout do kernel morton, também fora de TCS.
+    double time_convert = 0.0;
+    OocStats ooc;
+    MemStats mem;
+    std::vector<ThreadStats> threads;
+    size_t extra_bytes = 0;
+    double perf[kPerfEvents] = {};
+    // Tempos de cada repetição medida: {TCS, TAM, TDM}.
+    std::vector<std::array<double, 3>> samples;
+};
+
+// Memória de uma matriz conforme --alloc:
+//  - vector: std::vector<T> novo a cada repetição (comportamento original);
+//  - arena: blocos alinhados em 64 bytes guardados em ArenaBlock e
+//    reaproveitados em todas as repetições e pontos (só crescem);
+//  - hugepage: bloco novo a cada repetição, alinhado e arredondado para
+//    2 MB, com madvise(MADV_HUGEPAGE) para o kernel usar páginas enormes
+//    transparentes (THP).
+// Nos três casos a matriz começa zerada, a não ser com zeroed = false
+// (--init parallel): aí nenhuma página é tocada na alocação (vector vira
+// new T[] sem inicialização) e first_touch faz o primeiro acesso.
+static const size_t kHugePageBytes = static_cast<size_t>(2) * 1024 * 1024;
+
+static void *aligned_bytes(size_t bytes, size_t alignment)
+{
+#ifdef _WIN32
+    void *data = _aligned_malloc(bytes, alignment);
+#else
+    void *data = nullptr;
+    if (posix_memalign(&data, alignment, bytes) != 0)
+    {
+        data = nullptr;
+    }
+#endif
+    if (data == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+static void free_aligned_bytes(void *data)
+{
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    std::free(data);
+#endif
+}
+
+struct ArenaBlock
+{
+    void *data = nullptr;
+    size_t capacity = 0;
+
+    ~ArenaBlock()
+    {
+        free_aligned_bytes(data);
+    }
+};
+
+// Um bloco por matriz (mat1, mat2, res).
+static ArenaBlock g_arena[3];
+
+template <typename T>
+class MatrixStorage
+{
+public:
+    MatrixStorage(size_t count, AllocPolicy policy, int slot, bool zeroed = true) : policy_(policy)
+    {
+        const size_t bytes = count * sizeof(T);
+        if (policy_ == AllocPolicy::Vector && !zeroed)
+        {
+            untouched_.reset(new T[std::max<size_t>(count, 1)]);
+            data_ = untouched_.get();
+            return;
+        }
+        if (policy_ == AllocPolicy::Vector)
+        {
+            vector_.resize(count);
+            data_ = vector_.data();
+            return;
+        }
+
+        if (policy_ == AllocPolicy::Arena)
+        {
+            ArenaBlock &block = g_arena[slot];
+            if (block.capacity < bytes)
+            {
+                free_aligned_bytes(block.data);
+                block.data = nullptr;
+                block.capacity = 0;
+                block.data = aligned_bytes(std::max<size_t>(bytes, 64), 64);
+                block.capacity = bytes;
+            }
+            data_ = static_cast<T *>(block.data);
+        }
+        else
+        {
+            const size_t rounded = (bytes + kHugePageBytes - 1) / kHugePageBytes * kHugePageBytes;
+            void *block = aligned_bytes(std::max(rounded, kHugePageBytes), kHugePageBytes);
+#ifdef MATRIZ_MADVISE
+            madvise(block, std::max(rounded, kHugePageBytes), MADV_HUGEPAGE);
+#endif
+            data_ = static_cast<T *>(block);
+        }
+        if (zeroed)
+        {
+            std::fill(data_, data_ + count, T(0));
+        }
+    }
+
+    MatrixStorage(const MatrixStorage &) = delete;
+    MatrixStorage &operator=(const MatrixStorage &) = delete;
+
+    ~MatrixStorage()
+    {
+        release();
+    }
+
+    T *data()
+    {
+        return data_;
+    }
+
+    const T *data() const
+    {
+        return data_;
+    }
+
+    // Devolve a memória (na arena ela continua reservada para a próxima repetição).
+    void release()
+    {
+        if (data_ == nullptr)
+        {
+            return;
+        }
+        if (policy_ == AllocPolicy::Vector)
+        {
+            std::vector<T>().swap(vector_);
+            untouched_.reset();
+        }
+        else if (policy_ == AllocPolicy::HugePage)
+        {
+            free_aligned_bytes(data_);
+        }
+        data_ = nullptr;
+    }
+
+private:
+    AllocPolicy policy_;
+    std::vector<T> vector_;
+    std::unique_ptr<T[]> untouched_;
+    T *data_ = nullptr;
+};
+
+// Motor fora do núcleo (--ooc <dir>): mat1, mat2 e res ficam em arquivos
+// mapeados em memória e só blocos cabem na memória de trabalho
+// (--ooc-mem MiB). res é calculada em blocos b x b; para cada bloco, faixas
+// de kb colunas de mat1 e kb linhas de mat2 são copiadas para buffers em
+// memória por uma thread leitora, que carrega o próximo par de faixas
+// enquanto o atual é multiplicado (buffer duplo) e pede ao kernel a faixa
+// seguinte com madvise(MADV_WILLNEED). T_IO soma leituras, escritas e o
+// msync final; T_COMPUTO é só o produto dos blocos; T_ESPERA é quanto o
+// cálculo ficou parado esperando a leitura (E/S não escondida).
+static const int kOocDepth = 256;
+
+#ifdef MATRIZ_MMAP
+// Arquivo de matriz criado com o tamanho exato, mapeado com MAP_SHARED e
+// apagado ao liberar.
+class MappedMatrix
+{
+public:
+    MappedMatrix(const std::string &path, size_t bytes) : path_(path), bytes_(std::max<size_t>(bytes, 1))
+    {
+        fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd_ < 0 || ::ftruncate(fd_, static_cast<off_t>(bytes_)) != 0)
+        {
+            release();
+            throw std::runtime_error("Erro ao criar arquivo de matriz: " + path);
+        }
+        void *data = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            release();
+            throw std::runtime_error("Erro ao mapear arquivo de matriz: " + path);
+        }
+        data_ = data;
+    }
+
+    MappedMatrix(const MappedMatrix &) = delete;
+    MappedMatrix &operator=(const MappedMatrix &) = delete;
+
+    ~MappedMatrix()
+    {
+        release();
+    }
+
+    void *data() const
+    {
+        return data_;
+    }
+
+    // Grava as páginas sujas no arquivo.
+    void sync() const
+    {
+        ::msync(data_, bytes_, MS_SYNC);
+    }
+
+    // Grava e tira o arquivo do cache de páginas, para que a multiplicação
+    // leia do disco e não da memória.
+    void drop_cache() const
+    {
+        sync();
+        ::madvise(data_, bytes_, MADV_DONTNEED);
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    // Pede leitura antecipada de [offset, offset + length).
+    void will_need(size_t offset, size_t length) const
+    {
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const size_t begin = offset / page * page;
+        ::madvise(static_cast<char *>(data_) + begin, std::min(bytes_, offset + length) - begin, MADV_WILLNEED);
+    }
+
+    void release()
+    {
+        if (data_ != nullptr)
+        {
+            ::munmap(data_, bytes_);
+            data_ = nullptr;
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            ::unlink(path_.c_str());
+            fd_ = -1;
+        }
+    }
+
+private:
+    std::string path_;
+    size_t bytes_;
+    int fd_ = -1;
+    void *data_ = nullptr;
+};
+
+// res[rows x cols] += a[rows x depth] * b[depth x cols], ordem i-k-j.
+template <typename T>
+static void panel_multiply(const T *a, const T *b, T *c, int rows, int depth, int cols)
+{
+    for (int i = 0; i < rows; i++)
+    {
+        T *c_row = c + static_cast<size_t>(i) * cols;
+        for (int k = 0; k < depth; k++)
+        {
+            const T a_ik = a[static_cast<size_t>(i) * depth + k];
+            const T *b_row = b + static_cast<size_t>(k) * cols;
+            for (int j = 0; j < cols; j++)
+            {
+                c_row[j] += a_ik * b_row[j];
+            }
+        }
+    }
+}
+
+// Lado b do bloco de res para caber em work_bytes junto com dois pares de
+// faixas: b^2 + 4 b kb elementos.
+static int ooc_block(int n, int depth, size_t work_bytes, size_t elem_bytes)
+{
+    const double elems = static_cast<double>(work_bytes) / static_cast<double>(elem_bytes);
+    const double kb = static_cast<double>(depth);
+    const int side = static_cast<int>(std::sqrt(4.0 * kb * kb + elems) - 2.0 * kb);
+    return std::min(n, side >= 64 ? side / 64 * 64 : side);
+}
+
+template <typename T>
+static void multiply_ooc(const MappedMatrix &file1, const MappedMatrix &file2, const MappedMatrix &file_res, int n,
+                         const Options &options, OocStats &stats)
+{
+    const T *mat1 = static_cast<const T *>(file1.data());
+    const T *mat2 = static_cast<const T *>(file2.data());
+    T *res = static_cast<T *>(file_res.data());
+    const int depth = std::min(n, kOocDepth);
+    const int block = ooc_block(n, depth, static_cast<size_t>(options.ooc_mem) << 20, sizeof(T));
+    if (block < 16)
+    {
+        throw std::runtime_error("Memoria de trabalho insuficiente para --ooc; aumente --ooc-mem");
+    }
+
+    // Passos em ordem: blocos de res por linhas e, dentro de cada um, as
+    // faixas de k.
+    struct Step
+    {
+        int i0;
+        int j0;
+        int k0;
+    };
+    std::vector<Step> steps;
+    for (int i0 = 0; i0 < n; i0 += block)
+    {
+        for (int j0 = 0; j0 < n; j0 += block)
+        {
+            for (int k0 = 0; k0 < n; k0 += depth)
+            {
+                steps.push_back({i0, j0, k0});
+            }
+        }
+    }
+
+    struct Panels
+    {
+        std::vector<T> a;
+        std::vector<T> b;
+        double time = 0.0;
+        double bytes = 0.0;
+    };
+    Panels panels[2];
+    for (Panels &buffer : panels)
+    {
+        buffer.a.resize(static_cast<size_t>(block) * depth);
+        buffer.b.resize(static_cast<size_t>(depth) * block);
+    }
+    std::vector<T> tile(static_cast<size_t>(block) * block);
+    stats.work_bytes = (tile.size() + 2 * (panels[0].a.size() + panels[0].b.size())) * sizeof(T);
+
+    auto prefetch = [&](const Step &step) {
+        const int rows = std::min(block, n - step.i0);
+        const int inner = std::min(depth, n - step.k0);
+        for (int i = 0; i < rows; i++)
+        {
+            file1.will_need((static_cast<size_t>(step.i0 + i) * n + step.k0) * sizeof(T), inner * sizeof(T));
+        }
+        file2.will_need(static_cast<size_t>(step.k0) * n * sizeof(T), static_cast<size_t>(inner) * n * sizeof(T));
+    };
+    auto load = [&](size_t s, Panels &buffer) {
+        const auto start = Clock::now();
+        const Step &step = steps[s];
+        const int rows = std::min(block, n - step.i0);
+        const int cols = std::min(block, n - step.j0);
+        const int inner = std::min(depth, n - step.k0);
+        if (s + 1 < steps.size())
+        {
+            prefetch(steps[s + 1]);
+        }
+        for (int i = 0; i < rows; i++)
+        {
+            std::copy_n(mat1 + static_cast<size_t>(step.i0 + i) * n + step.k0, inner,
+                        buffer.a.data() + static_cast<size_t>(i) * inner);
+        }
+        for (int k = 0; k < inner; k++)
+        {
+            std::copy_n(mat2 + static_cast<size_t>(step.k0 + k) * n + step.j0, cols,
+                        buffer.b.data() + static_cast<size_t>(k) * cols);
+        }
+        buffer.bytes = static_cast<double>(rows + cols) * inner * sizeof(T);
+        buffer.time = elapsed_seconds(start, Clock::now());
+    };
+
+    load(0, panels[0]);
+    stats.time_io += panels[0].time;
+    stats.io_bytes += panels[0].bytes;
+    for (size_t s = 0; s < steps.size(); s++)
+    {
+        Panels &current = panels[s % 2];
+        Panels &next = panels[(s + 1) % 2];
+        std::thread reader;
+        if (s + 1 < steps.size())
+        {
+            reader = std::thread([&, s]() {
+                pin_thread(options, 1);
+                load(s + 1, next);
+            });
+        }
+
+        const Step &step = steps[s];
+        const int rows = std::min(block, n - step.i0);
+        const int cols = std::min(block, n - step.j0);
+        const int inner = std::min(depth, n - step.k0);
+        auto start = Clock::now();
+        if (step.k0 == 0)
+        {
+            std::fill(tile.begin(), tile.end(), T(0));
+        }
+        panel_multiply(current.a.data(), current.b.data(), tile.data(), rows, inner, cols);
+        stats.time_compute += elapsed_seconds(start, Clock::now());
+
+        if (step.k0 + inner == n)
+        {
+            start = Clock::now();
+            for (int i = 0; i < rows; i++)
+            {
+                std::copy_n(tile.data() + static_cast<size_t>(i) * cols, cols,
+                            res + static_cast<size_t>(step.i0 + i) * n + step.j0);
+            }
+            stats.time_io += elapsed_seconds(start, Clock::now());
+            stats.io_bytes += static_cast<double>(rows) * cols * sizeof(T);
+        }
+
+        if (reader.joinable())
+        {
+            start = Clock::now();
+            reader.join();
+            stats.time_wait += elapsed_seconds(start, Clock::now());
+            stats.time_io += next.time;
+            stats.io_bytes += next.bytes;
+        }
+    }
+
+    const auto start = Clock::now();
+    file_res.sync();
+    stats.time_io += elapsed_seconds(start, Clock::now());
+}
+
+// Uma repetição fora do núcleo: TAM cria, preenche e grava os arquivos (e
+// os tira do cache de páginas), TCS é o produto inteiro e TDM apaga os
+// arquivos.
+template <typename T>
+static bool run_once_ooc(int n, const Options &options, PointResult &acc)
+{
+    const size_t bytes = static_cast<size_t>(n) * n * sizeof(T);
+
+    MemMark mark;
+    mem_begin(options, mark);
+    auto start = Clock::now();
+    MappedMatrix file1(options.ooc_dir + "/matriz_ooc_mat1.bin", bytes);
+    MappedMatrix file2(options.ooc_dir + "/matriz_ooc_mat2.bin", bytes);
+    MappedMatrix file_res(options.ooc_dir + "/matriz_ooc_res.bin", bytes);
+    fill_inputs(static_cast<T *>(file1.data()), static_cast<T *>(file2.data()), n, options);
+    file1.drop_cache();
+    file2.drop_cache();
+    auto end = Clock::now();
+    mem_end(options, mark, acc.mem, 0);
+    acc.time_alloc += elapsed_seconds(start, end);
+
+    OocStats stats;
+    mem_begin(options, mark);
+    if (g_perf.active())
+    {
+        g_perf.start();
+    }
+    start = Clock::now();
+    multiply_ooc<T>(file1, file2, file_res, n, options, stats);
+    end = Clock::now();
+    if (g_perf.active())
+    {
+        g_perf.stop(acc.perf);
+    }
+    mem_end(options, mark, acc.mem, 1);
+    acc.time_calc += elapsed_seconds(start, end);
+    acc.ooc.time_io += stats.time_io;
+    acc.ooc.time_compute += stats.time_compute;
+    acc.ooc.time_wait += stats.time_wait;
+    acc.ooc.io_bytes += stats.io_bytes;
+    acc.ooc.work_bytes = stats.work_bytes;
+
+    const T *res = static_cast<const T *>(file_res.data());
+    if (options.verify == Verify::Freivalds)
+    {
+        start = Clock::now();
+        const bool ok = freivalds(static_cast<const T *>(file1.data()), static_cast<const T *>(file2.data()), res, n,
+                                  options.seed);
+        acc.time_verify += elapsed_seconds(start, Clock::now());
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    else if (!verify_sample(res, n))
+    {
+        return false;
+    }
+
+    mem_begin(options, mark);
+    start = Clock::now();
+    file1.release();
+    file2.release();
+    file_res.release();
+    end = Clock::now();
+    mem_end(options, mark, acc.mem, 2);
+    acc.time_free += elapsed_seconds(start, end);
+
+    return true;
+}
+#endif
+
+static const char kMatrixMagic[8] = {'M', 'A', 'T', 'R', 'I', 'Z', 'B', '1'};
+static const std::uint64_t kMatrixAlignment = 4096;
+
+static std::uint64_t matrix_file_bytes(const MatrixFileHeader &header)
+{
+    return header.offset + header.rows * header.stride * header.elem_size;
+}
+
+// Lê e confere o cabeçalho; lança std::runtime_error se o arquivo não
+// estiver no formato ou for menor que a carga declarada.
+MatrixFileHeader read_matrix_header(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Erro ao abrir arquivo de matriz: " + path);
+    }
+    const std::uint64_t size = static_cast<std::uint64_t>(file.tellg());
+
+    MatrixFileHeader header{};
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    {
+        throw std::runtime_error("Arquivo de matriz sem cabecalho: " + path);
+    }
+
+    const bool valid_dtype = header.dtype <= static_cast<std::uint32_t>(DType::Double);
+    const bool valid = std::equal(kMatrixMagic, kMatrixMagic + 8, header.magic) && valid_dtype &&
+                       header.elem_size == dtype_size(static_cast<DType>(header.dtype)) && header.rows > 0 &&
+                       header.cols > 0 && header.stride >= header.cols && header.alignment > 0 &&
+                       (header.alignment & (header.alignment - 1)) == 0 && header.offset >= sizeof(header) &&
+                       header.offset % header.alignment == 0 && header.offset % header.elem_size == 0;
+    if (!valid)
+    {
+        throw std::runtime_error("Cabecalho de matriz invalido: " + path);
+    }
+    if (size < matrix_file_bytes(header))
+    {
+        throw std::runtime_error("Arquivo de matriz truncado: " + path);
+    }
+    return header;
+}
+
+#ifdef MATRIZ_MMAP
+// Arquivo no formato binário mapeado inteiro. Para leitura usa
+// MAP_POPULATE, então as páginas são lidas na carga e não dentro do TCS;
+// para escrita cria o arquivo com o cabeçalho e grava com msync ao liberar.
+class MatrixFile
+{
+public:
+    explicit MatrixFile(const std::string &path) : header_(read_matrix_header(path)), writable_(false)
+    {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        map(path, PROT_READ, MAP_PRIVATE | MAP_POPULATE);
+    }
+
+    MatrixFile(const std::string &path, DType dtype, std::uint64_t rows, std::uint64_t cols) : writable_(true)
+    {
+        std::copy(kMatrixMagic, kMatrixMagic + 8, header_.magic);
+        header_.dtype = static_cast<std::uint32_t>(dtype);
+        header_.elem_size = static_cast<std::uint32_t>(dtype_size(dtype));
+        header_.rows = rows;
+        header_.cols = cols;
+        header_.stride = cols;
+        header_.alignment = kMatrixAlignment;
+        header_.offset = kMatrixAlignment;
+        header_.reserved = 0;
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ >= 0 && ::ftruncate(fd_, static_cast<off_t>(matrix_file_bytes(header_))) != 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        map(path, PROT_READ | PROT_WRITE, MAP_SHARED);
+        std::memcpy(data_, &header_, sizeof(header_));
+    }
+
+    MatrixFile(const MatrixFile &) = delete;
+    MatrixFile &operator=(const MatrixFile &) = delete;
+
+    ~MatrixFile()
+    {
+        release();
+    }
+
+    const MatrixFileHeader &header() const
+    {
+        return header_;
+    }
+
+    template <typename T>
+    T *payload() const
+    {
+        return reinterpret_cast<T *>(static_cast<char *>(data_) + header_.offset);
+    }
+
+    void release()
+    {
+        if (data_ != nullptr)
+        {
+            if (writable_)
+            {
+                ::msync(data_, bytes_, MS_SYNC);
+            }
+            ::munmap(data_, bytes_);
+            data_ = nullptr;
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+    void map(const std::string &path, int protection, int flags)
+    {
+        bytes_ = static_cast<size_t>(matrix_file_bytes(header_));
+        void *data = fd_ < 0 ? MAP_FAILED : ::mmap(nullptr, bytes_, protection, flags, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            release();
+            throw std::runtime_error("Erro ao mapear arquivo de matriz: " + path);
+        }
+        data_ = data;
+    }
+
+    MatrixFileHeader header_{};
+    bool writable_;
+    int fd_ = -1;
+    void *data_ = nullptr;
+    size_t bytes_ = 0;
+};
+
+// Carga útil como matriz contígua: o próprio mapeamento quando stride ==
+// cols (sem cópia) ou uma cópia compactada em packed.
+template <typename T>
+static const T *file_matrix(const MatrixFile &file, std::vector<T> &packed)
+{
+    const MatrixFileHeader &header = file.header();
+    const T *data = file.payload<T>();
+    if (header.stride == header.cols)
+    {
+        return data;
+    }
+    packed.resize(static_cast<size_t>(header.rows * header.cols));
+    for (std::uint64_t row = 0; row < header.rows; row++)
+    {
+        std::copy_n(data + row * header.stride, header.cols, packed.data() + row * header.cols);
+    }
+    return packed.data();
+}
+
+// Uma repetição com mat1 e mat2 lidas de arquivos (--mat1/--mat2): TAM é a
+// carga (mmap com leitura das páginas, mais a cópia se stride != cols e a
+// criação de --res-out), TDM inclui o msync de --res-out.
+template <typename T>
+static bool run_once_files(int n, const Options &options, PointResult &acc)
+{
+    const size_t n2 = static_cast<size_t>(n) * n;
+
+    MemMark mark;
+    mem_begin(options, mark);
+    auto start = Clock::now();
+    MatrixFile file1(options.mat1);
+    MatrixFile file2(options.mat2);
+    std::vector<T> packed1;
+    std::vector<T> packed2;
+    const T *mat1 = file_matrix(file1, packed1);
+    const T *mat2 = file_matrix(file2, packed2);
+    std::unique_ptr<MatrixFile> file_res;
+    MatrixStorage<T> storage(options.res_out.empty() ? n2 : 0, options.alloc, 2);
+    T *res = storage.data();
+    if (!options.res_out.empty())
+    {
+        file_res.reset(new MatrixFile(options.res_out, options.dtype, static_cast<std::uint64_t>(n),
+                                      static_cast<std::uint64_t>(n)));
+        res = file_res->payload<T>();
+        std::fill(res, res + n2, T(0));
+    }
+    auto end = Clock::now();
+    mem_end(options, mark, acc.mem, 0);
+    acc.time_alloc += elapsed_seconds(start, end);
+
+    mem_begin(options, mark);
+    double convert = 0.0;
+    if (g_perf.active())
+    {
+        g_perf.start();
+    }
+    start = Clock::now();
+    const size_t extra_bytes = run_kernel(mat1, mat2, res, n, options, &acc.threads, &convert);
+    end = Clock::now();
+    if (g_perf.active())
+    {
+        g_perf.stop(acc.perf);
+    }
+    mem_end(options, mark, acc.mem, 1);
+    acc.time_calc += elapsed_seconds(start, end) - convert;
+    acc.time_convert += convert;
+    acc.extra_bytes = std::max(acc.extra_bytes, extra_bytes);
+
+    start = Clock::now();
+    const bool ok = freivalds(mat1, mat2, res, n, options.seed);
+    acc.time_verify += elapsed_seconds(start, Clock::now());
+    if (!ok)
+    {
+        return false;
+    }
+
+    mem_begin(options, mark);
+    start = Clock::now();
+    if (file_res)
+    {
+        file_res->release();
+    }
+    storage.release();
+    std::vector<T>().swap(packed1);
+    std::vector<T>().swap(packed2);
+    file1.release();
+    file2.release();
+    end = Clock::now();
+    mem_end(options, mark, acc.mem, 2);
+    acc.time_free += elapsed_seconds(start, end);
+
+    return true;
+}
+#endif
+
+template <typename T>
+static bool run_once_typed(int n, const Options &options, PointResult &acc)
+{
+#ifdef MATRIZ_MMAP
+    if (!options.ooc_dir.empty())
+    {
+        return run_once_ooc<T>(n, options, acc);
+    }
+    if (!options.mat1.empty())
+    {
+        return run_once_files<T>(n, options, acc);
+    }
+#endif
+
+    const size_t n_size = static_cast<size_t>(n);
+    if (n_size > std::numeric_limits<size_t>::max() / n_size)
+    {
+        std::cerr << "N muito grande: " << n << "\n";
+        return false;
+    }
+    const size_t n2 = n_size * n_size;
+
+    // TAM cobre a alocação, o primeiro toque e o preenchimento histórico da
+    // identidade. O gerador de --input random custa bem mais que i + j e
+    // roda depois, fora dos tempos, sobre páginas já tocadas; assim o TAM de
+    // random continua comparável com o de identity.
+    MemMark mark;
+    mem_begin(options, mark);
+    auto start = Clock::now();
+    const bool parallel_init = options.init == InitMode::Parallel;
+    const bool random = options.input == Input::Random;
+    MatrixStorage<T> mat1(n2, options.alloc, 0, !parallel_init);
+    MatrixStorage<T> mat2(n2, options.alloc, 1, !parallel_init);
+    MatrixStorage<T> res(n2, options.alloc, 2, !parallel_init);
+    if (parallel_init)
+    {
+        first_touch(mat1.data(), mat2.data(), res.data(), n, options, !random);
+    }
+    else if (!random)
+    {
+        fill_inputs(mat1.data(), mat2.data(), n, options);
+    }
+    auto end = Clock::now();
+    mem_end(options, mark, acc.mem, 0);
+    acc.time_alloc += elapsed_seconds(start, end);
+    if (random)
+    {
+        fill_inputs(mat1.data(), mat2.data(), n, options);
+    }
+
+    mem_begin(options, mark);
+    double convert = 0.0;
+    if (g_perf.active())
+    {
+        g_perf.start();
+    }
+    start = Clock::now();
+    const size_t extra_bytes = run_kernel(mat1.data(), mat2.data(), res.data(), n, options, &acc.threads, &convert);
+    end = Clock::now();
+    if (g_perf.active())
+    {
+        g_perf.stop(acc.perf);
+    }
+    mem_end(options, mark, acc.mem, 1);
+    acc.time_calc += elapsed_seconds(start, end) - convert;
+    acc.time_convert += convert;
+    acc.extra_bytes = std::max(acc.extra_bytes, extra_bytes);
+
+    if (options.verify == Verify::Freivalds)
+    {
+        start = Clock::now();
+        const bool ok = freivalds(mat1.data(), mat2.data(), res.data(), n, options.seed);
+        acc.time_verify += elapsed_seconds(start, Clock::now());
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    else if (!verify_sample(res.data(), n))
+    {
+        return false;
+    }
+
+    mem_begin(options, mark);
+    start = Clock::now();
+    mat1.release();
+    mat2.release();
+    res.release();
+    end = Clock::now();
+    mem_end(options, mark, acc.mem, 2);
+    acc.time_free += elapsed_seconds(start, end);
+
+    return true;
+}
+
+static bool run_once(int n, const Options &options, PointResult &acc)
+{
+    switch (options.dtype)
+    {
+    case DType::Int64:
+        return run_once_typed<std::int64_t>(n, options, acc);
+    case DType::Float:
+        return run_once_typed<float>(n, options, acc);
+    case DType::Double:
+        return run_once_typed<double>(n, options, acc);
+    case DType::Int32:
+        break;
+    }
+    return run_once_typed<std::int32_t>(n, options, acc);
+}
+
+// Quantil 0,975 da t de Student com df graus de liberdade (IC de 95%):
+// tabela até 30 e aproximação 1,96 + 2,5/df acima (erro < 0,002).
+static double t_quantile_975(int df)
+{
+    static const double table[30] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                     2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                     2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df < 1)
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (df <= 30)
+    {
+        return table[df - 1];
+    }
+    return 1.96 + 2.5 / static_cast<double>(df);
+}
+
+// Estatísticas do TCS de um ponto a partir das amostras por repetição.
+struct SampleStats
+{
+    double mean = 0.0;
+    double median = 0.0;
+    double min = 0.0;
+    double stddev = 0.0;
+    double p95 = 0.0;
+    double ci_half = 0.0;
+};
+
+// Percentil por interpolação linear entre as amostras ordenadas.
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    const double pos = p * static_cast<double>(sorted.size() - 1);
+    const size_t lo = static_cast<size_t>(pos);
+    const size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+}
+
+static SampleStats sample_stats(std::vector<double> values)
+{
+    SampleStats stats;
+    if (values.empty())
+    {
+        return stats;
+    }
+
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (double value : values)
+    {
+        sum += value;
+    }
+    const double count = static_cast<double>(values.size());
+    stats.mean = sum / count;
+    stats.median = percentile(values, 0.5);
+    stats.min = values.front();
+    stats.p95 = percentile(values, 0.95);
+
+    if (values.size() > 1)
+    {
+        double squares = 0.0;
+        for (double value : values)
+        {
+            squares += (value - stats.mean) * (value - stats.mean);
+        }
+        stats.stddev = std::sqrt(squares / (count - 1.0));
+        stats.ci_half = t_quantile_975(static_cast<int>(values.size()) - 1) * stats.stddev / std::sqrt(count);
+    }
+    return stats;
+}
+
+static SampleStats calc_stats(const PointResult &result)
+{
+    std::vector<double> calc_times;
+    calc_times.reserve(result.samples.size());
+    for (const auto &sample : result.samples)
+    {
+        calc_times.push_back(sample[0]);
+    }
+    return sample_stats(calc_times);
+}
+
+// Critério de parada de --ci-target: meia largura do IC de 95% do TCS até
+// target vezes a média. Só precisa de média e desvio, sem ordenar amostras.
+static bool ci_reached(const PointResult &result, double target)
+{
+    const size_t count = result.samples.size();
+    if (count < 2)
+    {
+        return false;
+    }
+    double sum = 0.0;
+    for (const auto &sample : result.samples)
+    {
+        sum += sample[0];
+    }
+    const double mean = sum / static_cast<double>(count);
+    double squares = 0.0;
+    for (const auto &sample : result.samples)
+    {
+        squares += (sample[0] - mean) * (sample[0] - mean);
+    }
+    const double stddev = std::sqrt(squares / static_cast<double>(count - 1));
+    const double ci_half = t_quantile_975(static_cast<int>(count) - 1) * stddev / std::sqrt(static_cast<double>(count));
+    return ci_half <= target * mean;
+}
+
+// Warm-up não cronometrado seguido das M repetições; devolve as médias.
+static bool run_point(int n, const Options &options, int m_count, PointResult &result)
+{
+    PointResult warm;
+    if (!run_once(n, options, warm))
+    {
+        return false;
+    }
+
+    // Faz ao menos M repetições; com --ci-target continua até a meia largura
+    // do IC de 95% do TCS ficar abaixo da fração pedida da média ou até
+    // --time-cap segundos neste ponto.
+    result = PointResult();
+    const auto begin = Clock::now();
+    while (true)
+    {
+        const double calc = result.time_calc;
+        const double alloc = result.time_alloc;
+        const double free_time = result.time_free;
+        if (!run_once(n, options, result))
+        {
+            return false;
+        }
+        result.samples.push_back({result.time_calc - calc, result.time_alloc - alloc, result.time_free - free_time});
+
+        const int done = static_cast<int>(result.samples.size());
+        if (done < m_count)
+        {
+            continue;
+        }
+        if (options.ci_target <= 0.0 || done >= kMaxRepetitions ||
+            elapsed_seconds(begin, Clock::now()) >= options.time_cap)
+        {
+            break;
+        }
+        if (ci_reached(result, options.ci_target))
+        {
+            break;
+        }
+    }
+
+    const double reps = static_cast<double>(result.samples.size());
+    result.time_alloc /= reps;
+    result.time_calc /= reps;
+    result.time_free /= reps;
+    result.time_verify /= reps;
+    result.time_convert /= reps;
+    result.ooc.time_io /= reps;
+    result.ooc.time_compute /= reps;
+    result.ooc.time_wait /= reps;
+    result.ooc.io_bytes /= reps;
+    for (int phase = 0; phase < kMemPhases; phase++)
+    {
+        result.mem.minor_faults[phase] /= reps;
+        result.mem.major_faults[phase] /= reps;
+    }
+    for (ThreadStats &thread : result.threads)
+    {
+        thread.busy /= reps;
+        thread.idle /= reps;
+        thread.pack /= reps;
+    }
+    for (double &count : result.perf)
+    {
+        count /= reps;
+    }
+    return true;
+}
+
+// Tempo de empacotamento do kernel packed por repetição: média entre as
+// threads, comparável ao TCS (que o inclui).
+static double mean_pack_time(const PointResult &result)
+{
+    double total = 0.0;
+    for (const ThreadStats &thread : result.threads)
+    {
+        total += thread.pack;
+    }
+    return result.threads.empty() ? 0.0 : total / static_cast<double>(result.threads.size());
+}
+
+// Uma linha por thread com as médias por repetição (tarefas e roubos
+// também são médias, por isso podem ser fracionários).
+static void write_sched_stats(std::ofstream *file, int n, const PointResult &result)
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    const double reps = static_cast<double>(result.samples.size());
+    for (size_t t = 0; t < result.threads.size(); t++)
+    {
+        const ThreadStats &stats = result.threads[t];
+        *file << n << "," << result.threads.size() << "," << t << ","
+              << (static_cast<double>(stats.tasks) / reps) << "," << (static_cast<double>(stats.steals) / reps) << ","
+              << stats.busy << "," << stats.idle << "\n";
+    }
+}
+
+// Médias por repetição; eventos indisponíveis (e o IPC sem ciclos ou
+// instruções) saem como N/A.
+static void write_perf_stats(std::ofstream *file, int n, int threads, const PointResult &result)
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    const auto write_event = [&](int event) {
+        if (g_perf.available(event))
+        {
+            *file << "," << result.perf[event];
+        }
+        else
+        {
+            *file << ",N/A";
+        }
+    };
+
+    *file << n << "," << threads;
+    write_event(0);
+    write_event(1);
+    if (g_perf.available(0) && g_perf.available(1) && result.perf[0] > 0.0)
+    {
+        *file << "," << (result.perf[1] / result.perf[0]);
+    }
+    else
+    {
+        *file << ",N/A";
+    }
+    for (int e = 2; e < kPerfEvents; e++)
+    {
+        write_event(e);
+    }
+    *file << "\n";
+}
+
+static void write_samples(std::ofstream *file, int n, int threads, const PointResult &result)
+{
+    if (file == nullptr)
+    {
+        return;
+    }
+
+    for (size_t rep = 0; rep < result.samples.size(); rep++)
+    {
+        const auto &sample = result.samples[rep];
+        *file << n << "," << threads << "," << rep << "," << sample[0] << "," << sample[1] << "," << sample[2] << "\n";
+    }
+}
+
+static std::vector<int> thread_counts(int max_threads)
+{
+    std::vector<int> counts;
+    for (int t = 1; t < max_threads; t *= 2)
+    {
+        counts.push_back(t);
+    }
+    counts.push_back(max_threads);
+    return counts;
+}
+
+// Autotuner (--tune): para cada N da varredura, busca por descida
+// coordenada (dois passes, um parâmetro por vez) os blocos tile_i/tile_j/
+// tile_k, o corte do Strassen e, se --max-threads for dado, threads e
+// escalonamento que minimizam o TCS (melhor de M execuções). O resultado vai
+// para um cache JSON por modelo de CPU, kernel e dtype, com faixas de N
+// delimitadas pela média geométrica entre os N ajustados; execuções normais
+// leem o cache e aplicam a faixa de cada N às opções não passadas
+// explicitamente.
+
+struct TuneAxis
+{
+    const char *option;
+    std::vector<int> values;
+    std::function<void(Options &, int)> apply;
+};
+
+static std::string trim(const std::string &text)
+{
+    const size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+    {
+        return "";
+    }
+    return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+// Modelo da CPU: "model name" de /proc/cpuinfo ou, fora do Linux, a marca
+// devolvida por cpuid (0x80000002..4).
+std::string cpu_model()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        const size_t colon = line.find(':');
+        if (line.compare(0, 10, "model name") == 0 && colon != std::string::npos)
+        {
+            return trim(line.substr(colon + 1));
+        }
+    }
+#ifdef MATRIZ_X86_SIMD
+    if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004)
+    {
+        unsigned int regs[12] = {};
+        for (unsigned int leaf = 0; leaf < 3; leaf++)
+        {
+            __get_cpuid(0x80000002 + leaf, &regs[leaf * 4], &regs[leaf * 4 + 1], &regs[leaf * 4 + 2],
+                        &regs[leaf * 4 + 3]);
+        }
+        std::string brand(reinterpret_cast<const char *>(regs), sizeof(regs));
+        return trim(brand.substr(0, brand.find('\0')));
+    }
+#endif
+    return "desconhecido";
+}
+
+bool same_target(const TuneEntry &entry, const std::string &cpu, const Options &options)
+{
+    return entry.cpu == cpu && entry.kernel == kernel_name(options.kernel) && entry.dtype == dtype_name(options.dtype);
+}
+
+// Entradas válidas do cache; arquivo ausente devolve lista vazia e arquivo
+// corrompido só gera um aviso (o próximo --tune o regrava).
+std::vector<TuneEntry> load_tune_cache(const std::string &path)
+{
+    std::vector<TuneEntry> entries;
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return entries;
+    }
+    const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    JsonValue root;
+    try
+    {
+        root = JsonReader(text).parse();
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Aviso: cache do autotuner ignorado (" << path << "): " << ex.what() << "\n";
+        return entries;
+    }
+
+    const JsonValue *list = root.find("entries");
+    if (list == nullptr || list->type != JsonValue::Type::Array)
+    {
+        return entries;
+    }
+    for (const JsonValue &item : list->items)
+    {
+        const char *const strings[] = {"cpu", "kernel", "dtype", "schedule"};
+        const char *const numbers[] = {"n",      "n_min",   "n_max",           "tile_i", "tile_j",
+                                       "tile_k", "threads", "strassen_cutoff", "tcs"};
+        bool complete = true;
+        for (const char *key : strings)
+        {
+            const JsonValue *value = item.find(key);
+            complete = complete && value != nullptr && value->type == JsonValue::Type::String;
+        }
+        for (const char *key : numbers)
+        {
+            const JsonValue *value = item.find(key);
+            complete = complete && value != nullptr && value->type == JsonValue::Type::Number;
+        }
+        if (!complete)
+        {
+            continue;
+        }
+
+        auto number = [&item](const char *key) { return static_cast<int>(item.find(key)->number); };
+        TuneEntry entry;
+        entry.cpu = item.find("cpu")->text;
+        entry.kernel = item.find("kernel")->text;
+        entry.dtype = item.find("dtype")->text;
+        entry.schedule = item.find("schedule")->text == "steal" ? Schedule::Steal : Schedule::Static;
+        entry.n = number("n");
+        entry.n_min = number("n_min");
+        entry.n_max = number("n_max");
+        entry.tile_i = std::max(1, number("tile_i"));
+        entry.tile_j = std::max(1, number("tile_j"));
+        entry.tile_k = std::max(1, number("tile_k"));
+        entry.threads = std::max(1, number("threads"));
+        entry.strassen_cutoff = std::max(1, number("strassen_cutoff"));
+        entry.time_calc = item.find("tcs")->number;
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+static void write_tune_entry(std::ostream &out, const TuneEntry &entry, const char *indent)
+{
+    out << indent << "{\"cpu\": " << json_string(entry.cpu) << ", \"kernel\": " << json_string(entry.kernel)
+        << ", \"dtype\": " << json_string(entry.dtype) << ", \"n\": " << entry.n << ", \"n_min\": " << entry.n_min
+        << ", \"n_max\": " << entry.n_max << ", \"tile_i\": " << entry.tile_i << ", \"tile_j\": " << entry.tile_j
+        << ", \"tile_k\": " << entry.tile_k << ", \"threads\": " << entry.threads
+        << ", \"schedule\": " << json_string(entry.schedule == Schedule::Steal ? "steal" : "static")
+        << ", \"strassen_cutoff\": " << entry.strassen_cutoff << ", \"tcs\": " << entry.time_calc << "}";
+}
+
+static bool save_tune_cache(const std::string &path, const std::vector<TuneEntry> &entries)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Erro ao gravar o cache do autotuner: " << path << "\n";
+        return false;
+    }
+
+    file << std::scientific << std::setprecision(6);
+    file << "{\n  \"version\": 1,\n  \"entries\": [";
+    for (size_t e = 0; e < entries.size(); e++)
+    {
+        file << (e == 0 ? "\n" : ",\n");
+        write_tune_entry(file, entries[e], "    ");
+    }
+    file << (entries.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    return true;
+}
+
+// Opções para N com a faixa do cache que o contém; o que foi passado na
+// linha de comando prevalece.
+static Options apply_tuning(const Options &options, const std::vector<TuneEntry> &tuning, int n)
+{
+    Options tuned = options;
+    for (const TuneEntry &entry : tuning)
+    {
+        if (n < entry.n_min || n > entry.n_max)
+        {
+            continue;
+        }
+        auto keep = [&options](const char *option) { return options.given.count(option) != 0; };
+        tuned.tile_i = keep("--tile-i") ? options.tile_i : entry.tile_i;
+        tuned.tile_j = keep("--tile-j") ? options.tile_j : entry.tile_j;
+        tuned.tile_k = keep("--tile-k") ? options.tile_k : entry.tile_k;
+        tuned.strassen_cutoff = keep("--strassen-cutoff") ? options.strassen_cutoff : entry.strassen_cutoff;
+        tuned.threads = keep("--threads") ? options.threads : entry.threads;
+        tuned.schedule = keep("--schedule") ? options.schedule : entry.schedule;
+        break;
+    }
+    return tuned;
+}
+
+static std::vector<TuneAxis> tune_axes(const Options &options, int n)
+{
+    auto up_to_n = [n](std::vector<int> values) {
+        std::vector<int> kept;
+        for (int value : values)
+        {
+            if (value <= n || kept.empty())
+            {
+                kept.push_back(value);
+            }
+        }
+        return kept;
+    };
+
+    std::vector<TuneAxis> axes;
+    if (options.kernel == Kernel::Blocked || options.kernel == Kernel::Simd)
+    {
+        axes.push_back({"--tile-i", up_to_n({16, 32, 64, 128}), [](Options &o, int v) { o.tile_i = v; }});
+        axes.push_back({"--tile-j", up_to_n({64, 128, 256, 512, 1024}), [](Options &o, int v) { o.tile_j = v; }});
+        axes.push_back({"--tile-k", up_to_n({64, 128, 256, 512}), [](Options &o, int v) { o.tile_k = v; }});
+    }
+    if (options.kernel == Kernel::Strassen)
+    {
+        axes.push_back(
+            {"--strassen-cutoff", up_to_n({32, 64, 128, 256}), [](Options &o, int v) { o.strassen_cutoff = v; }});
+    }
+    else if (options.given.count("--max-threads") != 0)
+    {
+        axes.push_back({"--threads", thread_counts(options.max_threads), [](Options &o, int v) { o.threads = v; }});
+        axes.push_back({"--schedule", {0, 1}, [](Options &o, int v) {
+                            o.schedule = v == 0 ? Schedule::Static : Schedule::Steal;
+                        }});
+    }
+
+    // Parâmetros fixados na linha de comando ficam fora da busca.
+    axes.erase(std::remove_if(axes.begin(), axes.end(),
+                              [&options](const TuneAxis &axis) { return options.given.count(axis.option) != 0; }),
+               axes.end());
+    return axes;
+}
+
+bool has_tune_axes(const Options &options, int n)
+{
+    return !tune_axes(options, n).empty();
+}
+
+// Melhor (menor) TCS de M execuções, após uma não cronometrada.
+template <typename T>
+static double tune_time(const T *mat1, const T *mat2, T *res, int n, const Options &options, int m_count)
+{
+    run_kernel(mat1, mat2, res, n, options, nullptr);
+    double best = std::numeric_limits<double>::max();
+    for (int rep = 0; rep < m_count; rep++)
+    {
+        const auto start = Clock::now();
+        run_kernel(mat1, mat2, res, n, options, nullptr);
+        best = std::min(best, elapsed_seconds(start, Clock::now()));
+    }
+    return best;
+}
+
+template <typename T>
+static bool tune_typed(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file,
+                       std::vector<TuneEntry> &found)
+{
+    for (int n : points)
+    {
+        const size_t n2 = static_cast<size_t>(n) * n;
+        std::vector<T> mat1(n2);
+        std::vector<T> mat2(n2);
+        std::vector<T> res(n2);
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                mat1[static_cast<size_t>(i) * n + j] = static_cast<T>(i + j);
+                mat2[static_cast<size_t>(i) * n + j] = (i == j) ? T(1) : T(0);
+            }
+        }
+
+        Options best = options;
+        const double time_default = tune_time(mat1.data(), mat2.data(), res.data(), n, best, m_count);
+        double time_best = time_default;
+        const std::vector<TuneAxis> axes = tune_axes(options, n);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            bool improved = false;
+            for (const TuneAxis &axis : axes)
+            {
+                for (int value : axis.values)
+                {
+                    Options candidate = best;
+                    axis.apply(candidate, value);
+                    const double time = tune_time(mat1.data(), mat2.data(), res.data(), n, candidate, m_count);
+                    if (time < time_best)
+                    {
+                        best = candidate;
+                        time_best = time;
+                        improved = true;
+                    }
+                }
+            }
+            if (!improved)
+            {
+                break;
+            }
+        }
+
+        std::fill(res.begin(), res.end(), T(0));
+        run_kernel(mat1.data(), mat2.data(), res.data(), n, best, nullptr);
+        if (!verify_sample(res.data(), n))
+        {
+            return false;
+        }
+
+        TuneEntry entry;
+        entry.kernel = kernel_name(options.kernel);
+        entry.dtype = dtype_name(options.dtype);
+        entry.n = n;
+        entry.tile_i = best.tile_i;
+        entry.tile_j = best.tile_j;
+        entry.tile_k = best.tile_k;
+        entry.threads = best.threads;
+        entry.schedule = best.schedule;
+        entry.strassen_cutoff = best.strassen_cutoff;
+        entry.time_calc = time_best;
+        found.push_back(entry);
+
+        file << n << "," << entry.tile_i << "," << entry.tile_j << "," << entry.tile_k << "," << entry.threads << ","
+             << entry.strassen_cutoff << "," << time_best << "," << time_default << "," << (time_default / time_best)
+             << "\n";
+        std::cout << "Ajuste para N = " << n << ": tiles " << entry.tile_i << "x" << entry.tile_j << "x"
+                  << entry.tile_k << ", " << entry.threads << " thread(s), corte " << entry.strassen_cutoff
+                  << ", ganho " << (time_default / time_best) << "x.\n";
+    }
+    return true;
+}
+
+// Executa a busca, grava o CSV de ajuste e substitui no cache as entradas
+// desta CPU, kernel e dtype. Devolve as novas entradas em tuning.
+bool run_tune(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file,
+              const std::string &cpu, std::vector<TuneEntry> &tuning)
+{
+    file << "N,TILE_I,TILE_J,TILE_K,THREADS,STRASSEN_CUTOFF,TCS,TCS_PADRAO,GANHO\n";
+
+    std::vector<int> sorted = points;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    bool ok = false;
+    switch (options.dtype)
+    {
+    case DType::Int64:
+        ok = tune_typed<std::int64_t>(sorted, options, m_count, file, tuning);
+        break;
+    case DType::Float:
+        ok = tune_typed<float>(sorted, options, m_count, file, tuning);
+        break;
+    case DType::Double:
+        ok = tune_typed<double>(sorted, options, m_count, file, tuning);
+        break;
+    case DType::Int32:
+        ok = tune_typed<std::int32_t>(sorted, options, m_count, file, tuning);
+        break;
+    }
+    if (!ok)
+    {
+        return false;
+    }
+
+    for (size_t e = 0; e < tuning.size(); e++)
+    {
+        tuning[e].cpu = cpu;
+        tuning[e].n_min = e == 0 ? 1 : tuning[e - 1].n_max + 1;
+        tuning[e].n_max = e + 1 == tuning.size()
+                              ? std::numeric_limits<int>::max()
+                              : static_cast<int>(std::sqrt(static_cast<double>(tuning[e].n) * tuning[e + 1].n));
+    }
+
+    std::vector<TuneEntry> cache = load_tune_cache(options.tune_cache);
+    cache.erase(std::remove_if(cache.begin(), cache.end(),
+                               [&](const TuneEntry &entry) { return same_target(entry, cpu, options); }),
+                cache.end());
+    cache.insert(cache.end(), tuning.begin(), tuning.end());
+    if (!save_tune_cache(options.tune_cache, cache))
+    {
+        return false;
+    }
+    std::cout << "Cache do autotuner atualizado: " << options.tune_cache << " (" << cpu << ").\n";
+    return true;
+}
+
+bool run_threads_sweep(const std::vector<int> &points, const Options &options,
+                       const std::vector<TuneEntry> &tuning, int m_count, std::ofstream &file,
+                       std::ofstream *stats_file, std::ofstream *perf_file, std::ofstream *samples_file)
+{
+    file << "N,THREADS,TCS,SPEEDUP,EFICIENCIA\n";
+
+    for (int n : points)
+    {
+        double time_serial = 0.0;
+        Options point_options = apply_tuning(options, tuning, n);
+        for (int threads : thread_counts(options.max_threads))
+        {
+            PointResult result;
+
+            point_options.threads = threads;
+            if (!run_point(n, point_options, m_count, result))
+            {
+                return false;
+            }
+            if (threads == 1)
+            {
+                time_serial = result.time_calc;
+            }
+
+            const double speedup = time_serial / result.time_calc;
+            file << n << "," << threads << "," << result.time_calc << "," << speedup << ","
+                 << (speedup / static_cast<double>(threads)) << "\n";
+            write_sched_stats(stats_file, n, result);
+            write_perf_stats(perf_file, n, threads, result);
+            write_samples(samples_file, n, threads, result);
+        }
+
+        std::cout << "Escalonamento para N = " << n << " salvo.\n";
+    }
+
+    return true;
+}
+
+// Varredura de kernels (--sweep k1,k2,...): todas as combinações de kernel
+// e --sweep-dtypes rodam no mesmo processo e intercaladas. Para cada N,
+// cada combinação faz um aquecimento e depois as rodadas medidas passam uma
+// repetição por combinação, começando cada rodada por uma combinação
+// diferente, para que estado térmico, frequência e ruído do sistema caiam
+// igualmente sobre todas. O resultado é um CSV único (e o mesmo conteúdo
+// em --results-json, com as amostras) com kernel, dtype, threads, N e as
+// estatísticas do TCS.
+struct SweepEntry
+{
+    Options options;
+    std::vector<TuneEntry> tuning;
+    PointResult result;
+};
+
+static std::vector<SweepEntry> sweep_entries(const Options &options, const std::string &cpu)
+{
+    const std::vector<TuneEntry> cache = load_tune_cache(options.tune_cache);
+    std::vector<SweepEntry> entries;
+    for (DType dtype : options.sweep_dtypes)
+    {
+        for (Kernel kernel : options.sweep_kernels)
+        {
+            SweepEntry entry;
+            entry.options = options;
+            entry.options.kernel = kernel;
+            entry.options.dtype = dtype;
+            if (uses_isa(kernel) && dtype == DType::Int64)
+            {
+                entry.options.isa = Isa::Scalar;
+            }
+            for (const TuneEntry &tune : cache)
+            {
+                if (same_target(tune, cpu, entry.options))
+                {
+                    entry.tuning.push_back(tune);
+                }
+            }
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+// Aquecimento e rodadas intercaladas de um N; com --ci-target continua até
+// todas as combinações atingirem o alvo ou até --time-cap.
+static bool sweep_point(int n, std::vector<SweepEntry> &entries, const Options &options, int m_count)
+{
+    std::vector<Options> point_options;
+    for (SweepEntry &entry : entries)
+    {
+        entry.result = PointResult();
+        point_options.push_back(apply_tuning(entry.options, entry.tuning, n));
+        PointResult warm;
+        if (!run_once(n, point_options.back(), warm))
+        {
+            return false;
+        }
+    }
+
+    const size_t count = entries.size();
+    const auto begin = Clock::now();
+    for (int round = 0;; round++)
+    {
+        for (size_t c = 0; c < count; c++)
+        {
+            const size_t idx = (c + static_cast<size_t>(round)) % count;
+            PointResult &result = entries[idx].result;
+            const double calc = result.time_calc;
+            const double alloc = result.time_alloc;
+            const double free_time = result.time_free;
+            if (!run_once(n, point_options[idx], result))
+            {
+                return false;
+            }
+            result.samples.push_back(
+                {result.time_calc - calc, result.time_alloc - alloc, result.time_free - free_time});
+        }
+
+        if (round + 1 < m_count)
+        {
+            continue;
+        }
+        if (options.ci_target <= 0.0 || round + 1 >= kMaxRepetitions ||
+            elapsed_seconds(begin, Clock::now()) >= options.time_cap)
+        {
+            break;
+        }
+        bool done = round >= 1;
+        for (const SweepEntry &entry : entries)
+        {
+            done = done && ci_reached(entry.result, options.ci_target);
+        }
+        if (done)
+        {
+            break;
+        }
+    }
+
+    for (SweepEntry &entry : entries)
+    {
+        const double reps = static_cast<double>(entry.result.samples.size());
+        entry.result.time_calc /= reps;
+        entry.result.time_alloc /= reps;
+        entry.result.time_free /= reps;
+        entry.result.time_verify /= reps;
+        entry.result.time_convert /= reps;
+        for (ThreadStats &thread : entry.result.threads)
+        {
+            thread.pack /= reps;
+        }
+    }
+    return true;
+}
+
+bool run_sweep(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file,
+               const std::string &cpu)
+{
+    std::ofstream json;
+    if (!options.results_json.empty())
+    {
+        json.open(options.results_json);
+        if (!json.is_open())
+        {
+            std::cerr << "Erro ao abrir arquivo de saida: " << options.results_json << "\n";
+            return false;
+        }
+        json << std::scientific << std::setprecision(6);
+        json << "{\n"
+             << "  \"version\": 1,\n"
+             << "  \"cpu_model\": " << json_string(cpu) << ",\n"
+             << "  \"order\": \"interleaved\",\n"
+             << "  \"results\": [";
+    }
+
+    file << "N,KERNEL,DTYPE,ISA,THREADS,REPS,TCS,TAM,TDM,T_CONVERSAO,T_EMPACOTAMENTO,TCS_MEDIANA,TCS_MIN,"
+            "TCS_DESVIO,TCS_P95,TCS_IC95_INF,TCS_IC95_SUP,GOPS\n";
+
+    std::vector<SweepEntry> entries = sweep_entries(options, cpu);
+    bool first = true;
+    for (int n : points)
+    {
+        if (!sweep_point(n, entries, options, m_count))
+        {
+            return false;
+        }
+
+        for (const SweepEntry &entry : entries)
+        {
+            const Options &config = entry.options;
+            const PointResult &result = entry.result;
+            const SampleStats stats = calc_stats(result);
+            const int threads = config.kernel == Kernel::Strassen ? 1 : apply_tuning(config, entry.tuning, n).threads;
+            const char *isa = uses_isa(config.kernel) ? isa_name(config.isa) : "N/A";
+            const double gops = 2.0 * static_cast<double>(n) * n * n / result.time_calc / 1e9;
+            file << n << "," << kernel_name(config.kernel) << "," << dtype_name(config.dtype) << "," << isa << ","
+                 << threads << "," << result.samples.size() << "," << result.time_calc << "," << result.time_alloc
+                 << "," << result.time_free << "," << result.time_convert << "," << mean_pack_time(result) << ","
+                 << stats.median << "," << stats.min << "," << stats.stddev << ","
+                 << stats.p95 << "," << (stats.mean - stats.ci_half) << "," << (stats.mean + stats.ci_half) << ","
+                 << gops << "\n";
+
+            if (json.is_open())
+            {
+                json << (first ? "\n" : ",\n") << "    {\"n\": " << n
+                     << ", \"kernel\": " << json_string(kernel_name(config.kernel))
+                     << ", \"dtype\": " << json_string(dtype_name(config.dtype)) << ", \"isa\": " << json_string(isa)
+                     << ", \"threads\": " << threads << ", \"reps\": " << result.samples.size()
+                     << ",\n     \"tcs\": {\"mean\": " << result.time_calc << ", \"median\": " << stats.median
+                     << ", \"min\": " << stats.min << ", \"stddev\": " << stats.stddev << ", \"p95\": " << stats.p95
+                     << ", \"ci95_low\": " << (stats.mean - stats.ci_half)
+                     << ", \"ci95_high\": " << (stats.mean + stats.ci_half) << "},\n     \"tam\": " << result.time_alloc
+                     << ", \"tdm\": " << result.time_free << ", \"t_convert\": " << result.time_convert
+                     << ", \"t_pack\": " << mean_pack_time(result) << ", \"gops\": " << gops
+                     << ",\n     \"samples\": [";
+                for (size_t s = 0; s < result.samples.size(); s++)
+                {
+                    json << (s == 0 ? "" : ", ") << result.samples[s][0];
+                }
+                json << "]}";
+                first = false;
+            }
+        }
+        std::cout << "Varredura de " << entries.size() << " kernel(s) para N = " << n << " salva.\n";
+    }
+
+    if (json.is_open())
+    {
+        json << (first ? "]\n" : "\n  ]\n") << "}\n";
+    }
+    return true;
+}
+
+// Modo lote (--batch): muitas matrizes pequenas do mesmo tamanho, contíguas
+// em memória. Com N em constexpr os laços k e j são desenrolados por inteiro
+// e a linha acumulada de res fica em registradores; o kernel genérico faz o
+// mesmo produto com N em tempo de execução, como referência.
+static const int kBatchSizes[] = {4, 8, 12, 16, 24, 32};
+
+template <typename T, int N>
+static void gemm_fixed(const T *mat1, const T *mat2, T *res)
+{
+    for (int i = 0; i < N; i++)
+    {
+        T acc[N] = {};
+        // Sem o desenrolar explícito o GCC vetoriza o laço k (passo N em
+        // mat2, com transposições) em vez das colunas j contíguas.
+#pragma GCC unroll 32
+        for (int k = 0; k < N; k++)
+        {
+            const T a = mat1[i * N + k];
+#pragma GCC unroll 32
+            for (int j = 0; j < N; j++)
+            {
+                acc[j] += a * mat2[k * N + j];
+            }
+        }
+        for (int j = 0; j < N; j++)
+        {
+            res[i * N + j] = acc[j];
+        }
+    }
+}
+
+template <typename T>
+static void gemm_dynamic(const T *mat1, const T *mat2, T *res, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        T *row = res + static_cast<size_t>(i) * n;
+        std::fill(row, row + n, T(0));
+        for (int k = 0; k < n; k++)
+        {
+            const T a = mat1[i * n + k];
+            for (int j = 0; j < n; j++)
+            {
+                row[j] += a * mat2[k * n + j];
+            }
+        }
+    }
+}
+
+template <typename T, int N>
+static void batch_fixed(const T *mat1, const T *mat2, T *res, size_t count)
+{
+    constexpr size_t stride = static_cast<size_t>(N) * N;
+    for (size_t m = 0; m < count; m++)
+    {
+        gemm_fixed<T, N>(mat1 + m * stride, mat2 + m * stride, res + m * stride);
+    }
+}
+
+template <typename T>
+static void batch_dynamic(const T *mat1, const T *mat2, T *res, int n, size_t count)
+{
+    const size_t stride = static_cast<size_t>(n) * n;
+    for (size_t m = 0; m < count; m++)
+    {
+        gemm_dynamic(mat1 + m * stride, mat2 + m * stride, res + m * stride, n);
+    }
+}
+
+template <typename T>
+static void batch_specialized(const T *mat1, const T *mat2, T *res, int n, size_t count)
+{
+    switch (n)
+    {
+    case 4:
+        batch_fixed<T, 4>(mat1, mat2, res, count);
+        return;
+    case 8:
+        batch_fixed<T, 8>(mat1, mat2, res, count);
+        return;
+    case 12:
+        batch_fixed<T, 12>(mat1, mat2, res, count);
+        return;
+    case 16:
+        batch_fixed<T, 16>(mat1, mat2, res, count);
+        return;
+    case 24:
+        batch_fixed<T, 24>(mat1, mat2, res, count);
+        return;
+    case 32:
+        batch_fixed<T, 32>(mat1, mat2, res, count);
+        return;
+    }
+    throw std::invalid_argument("Sem kernel especializado para N=" + std::to_string(n));
+}
+
+// mat2 é a identidade, então cada matriz de res deve repetir a de mat1.
+template <typename T>
+static bool verify_batch(const std::vector<T> &mat1, const std::vector<T> &res, int n, size_t count)
+{
+    const size_t stride = static_cast<size_t>(n) * n;
+    const size_t samples[3] = {0, count / 2, count - 1};
+
+    for (size_t m : samples)
+    {
+        for (size_t e = 0; e < stride; e++)
+        {
+            if (!matches(res[m * stride + e], static_cast<double>(mat1[m * stride + e]), n))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T>
+static bool run_batch_typed(const Options &options, int m_count, std::ofstream &file)
+{
+    const size_t count = static_cast<size_t>(options.batch);
+
+    for (int n : kBatchSizes)
+    {
+        const size_t stride = static_cast<size_t>(n) * n;
+        std::vector<T> mat1(count * stride);
+        std::vector<T> mat2(count * stride);
+        std::vector<T> res(count * stride);
+
+        for (size_t m = 0; m < count; m++)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                for (int j = 0; j < n; j++)
+                {
+                    const size_t idx = m * stride + static_cast<size_t>(i) * n + j;
+                    mat1[idx] = static_cast<T>(i + j + static_cast<int>(m % 16));
+                    mat2[idx] = (i == j) ? T(1) : T(0);
+                }
+            }
+        }
+
+        double time_fixed = 0.0;
+        double time_dynamic = 0.0;
+        for (int rep = -1; rep < m_count; rep++)
+        {
+            auto start = Clock::now();
+            batch_specialized(mat1.data(), mat2.data(), res.data(), n, count);
+            auto end = Clock::now();
+            if (!verify_batch(mat1, res, n, count))
+            {
+                std::cerr << "Erro no lote especializado para N=" << n << "\n";
+                return false;
+            }
+            if (rep >= 0)
+            {
+                time_fixed += elapsed_seconds(start, end);
+            }
+
+            std::fill(res.begin(), res.end(), T(0));
+            start = Clock::now();
+            batch_dynamic(mat1.data(), mat2.data(), res.data(), n, count);
+            end = Clock::now();
+            if (!verify_batch(mat1, res, n, count))
+            {
+                std::cerr << "Erro no lote generico para N=" << n << "\n";
+                return false;
+            }
+            if (rep >= 0)
+            {
+                time_dynamic += elapsed_seconds(start, end);
+            }
+        }
+
+        time_fixed /= static_cast<double>(m_count);
+        time_dynamic /= static_cast<double>(m_count);
+        const double mats = static_cast<double>(count);
+        const double flops = 2.0 * static_cast<double>(n) * n * n * mats;
+        file << n << "," << count << "," << time_fixed << "," << time_dynamic << "," << (mats / time_fixed) << ","
+             << (mats / time_dynamic) << "," << (flops / time_fixed * 1e-9) << "," << (flops / time_dynamic * 1e-9)
+             << "\n";
+
+        std::cout << "Lote de " << count << " matrizes " << n << "x" << n << " salvo.\n";
+    }
+
+    return true;
+}
+
+bool run_batch(const Options &options, int m_count, std::ofstream &file)
+{
+    file << "N,LOTE,T_ESPECIALIZADO,T_GENERICO,MATS_S_ESPECIALIZADO,MATS_S_GENERICO,GFLOPS_ESPECIALIZADO,"
+            "GFLOPS_GENERICO\n";
+
+    switch (options.dtype)
+    {
+    case DType::Int64:
+        return run_batch_typed<std::int64_t>(options, m_count, file);
+    case DType::Float:
+        return run_batch_typed<float>(options, m_count, file);
+    case DType::Double:
+        return run_batch_typed<double>(options, m_count, file);
+    case DType::Int32:
+        break;
+    }
+    return run_batch_typed<std::int32_t>(options, m_count, file);
+}
+
+// GEMM geral no estilo BLAS, por linhas: C = alpha op(A) op(B) + beta C,
+// com C M x N, op(A) M x K e op(B) K x N. lda, ldb e ldc são os passos
+// entre linhas (>= largura armazenada), o que permite operar sobre
+// submatrizes de matrizes maiores. Com beta = 0, C não é lida.
+template <typename T>
+struct GemmArgs
+{
+    bool trans_a = false;
+    bool trans_b = false;
+    int m = 0;
+    int n = 0;
+    int k = 0;
+    T alpha = T(1);
+    const T *a = nullptr;
+    int lda = 0;
+    const T *b = nullptr;
+    int ldb = 0;
+    T beta = T(0);
+    T *c = nullptr;
+    int ldc = 0;
+};
+
+template <typename T>
+static void check_gemm(const GemmArgs<T> &g)
+{
+    if (g.m < 0 || g.n < 0 || g.k < 0)
+    {
+        throw std::invalid_argument("GEMM com M, N ou K negativo");
+    }
+    if (g.lda < std::max(1, g.trans_a ? g.m : g.k) || g.ldb < std::max(1, g.trans_b ? g.k : g.n) ||
+        g.ldc < std::max(1, g.n))
+    {
+        throw std::invalid_argument("GEMM com lda, ldb ou ldc menor que a largura da matriz");
+    }
+    if ((g.m > 0 && g.n > 0 && g.c == nullptr) || (g.k > 0 && (g.a == nullptr || g.b == nullptr)))
+    {
+        throw std::invalid_argument("GEMM com matriz nula");
+    }
+}
+
+// Linhas [row_begin, row_end) de C em blocos tile_i x tile_k x tile_j na
+// ordem kk-jj-ii: o painel de op(B) (tile_k x tile_j) fica em cache
+// enquanto os blocos de op(A) passam por ele. Operando sem transposição é
+// lido no lugar, com passo ld; operando transposto é copiado para um
+// buffer contíguo por linhas: de A, a faixa inteira de linhas x tile_k uma
+// vez por kk (lida linha a linha de A e reaproveitada por todos os painéis
+// jj), de B, o painel coluna a coluna. Assim nn, nt, tn e tt caem no mesmo laço
+// interno i-k-j de passo unitário, vetorizável pelo compilador.
+template <typename T>
+static void gemm_rows(const GemmArgs<T> &g, int row_begin, int row_end, const Options &options)
+{
+    for (int i = row_begin; i < row_end; i++)
+    {
+        T *row = g.c + static_cast<size_t>(i) * g.ldc;
+        if (g.beta == T(0))
+        {
+            std::fill(row, row + g.n, T(0));
+        }
+        else if (g.beta != T(1))
+        {
+            for (int j = 0; j < g.n; j++)
+            {
+                row[j] *= g.beta;
+            }
+        }
+    }
+    if (g.k == 0 || g.alpha == T(0) || row_begin >= row_end)
+    {
+        return;
+    }
+
+    const int tile_i = std::min(options.tile_i, row_end - row_begin);
+    const int tile_j = std::min(options.tile_j, g.n);
+    const int tile_k = std::min(options.tile_k, g.k);
+    std::vector<T> a_pack(g.trans_a ? static_cast<size_t>(row_end - row_begin) * tile_k : 0);
+    std::vector<T> b_pack(g.trans_b ? static_cast<size_t>(tile_k) * tile_j : 0);
+
+    for (int kk = 0; kk < g.k; kk += tile_k)
+    {
+        const int k_end = std::min(kk + tile_k, g.k);
+        const int kb = k_end - kk;
+        if (g.trans_a)
+        {
+            for (int p = kk; p < k_end; p++)
+            {
+                const T *src = g.a + static_cast<size_t>(p) * g.lda;
+                for (int i = row_begin; i < row_end; i++)
+                {
+                    a_pack[static_cast<size_t>(i - row_begin) * kb + (p - kk)] = src[i];
+                }
+            }
+        }
+        for (int jj = 0; jj < g.n; jj += tile_j)
+        {
+            const int j_end = std::min(jj + tile_j, g.n);
+            const int jb = j_end - jj;
+            const T *panel = g.b + static_cast<size_t>(kk) * g.ldb + jj;
+            size_t ld_panel = static_cast<size_t>(g.ldb);
+            if (g.trans_b)
+            {
+                for (int j = jj; j < j_end; j++)
+                {
+                    const T *src = g.b + static_cast<size_t>(j) * g.ldb;
+                    for (int p = kk; p < k_end; p++)
+                    {
+                        b_pack[static_cast<size_t>(p - kk) * jb + (j - jj)] = src[p];
+                    }
+                }
+                panel = b_pack.data();
+                ld_panel = static_cast<size_t>(jb);
+            }
+
+            for (int ii = row_begin; ii < row_end; ii += tile_i)
+            {
+                const int i_end = std::min(ii + tile_i, row_end);
+                const T *block = g.a + static_cast<size_t>(ii) * g.lda + kk;
+                size_t ld_block = static_cast<size_t>(g.lda);
+                if (g.trans_a)
+                {
+                    block = a_pack.data() + static_cast<size_t>(ii - row_begin) * kb;
+                    ld_block = static_cast<size_t>(kb);
+                }
+
+                for (int i = ii; i < i_end; i++)
+                {
+                    const T *a_row = block + static_cast<size_t>(i - ii) * ld_block;
+                    T *c_row = g.c + static_cast<size_t>(i) * g.ldc + jj;
+                    for (int p = 0; p < kb; p++)
+                    {
+                        const T value = g.alpha * a_row[p];
+                        const T *b_row = panel + static_cast<size_t>(p) * ld_panel;
+                        for (int j = 0; j < jb; j++)
+                        {
+                            c_row[j] += value * b_row[j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Faixas contíguas de ceil(M / T) linhas de C, uma por thread (--threads,
+// --pin); cada thread usa seus próprios buffers de cópia.
+template <typename T>
+static void gemm(const GemmArgs<T> &g, const Options &options)
+{
+    check_gemm(g);
+    const int threads = std::max(1, std::min(options.threads, g.m));
+    const int chunk = (g.m + threads - 1) / threads;
+    run_parallel(threads, options, [&](int t) {
+        gemm_rows(g, std::min(t * chunk, g.m), std::min((t + 1) * chunk, g.m), options);
+    });
+}
+
+// Freivalds do GEMM: compara C r com alpha op(A) (op(B) r) + beta C0 r, em
+// O(MK + KN + MN), com as mesmas regras de freivalds (módulo 2^64 para
+// inteiros, 2 (K + 2) epsilon por linha para reais). C0 é a cópia de C
+// antes do produto, com o mesmo ldc; as colunas de folga entre N e ldc
+// devem continuar iguais às de C0.
+template <typename T>
+static bool gemm_check(const GemmArgs<T> &g, const T *c0, std::uint64_t seed)
+{
+    auto a_at = [&g](int i, int p) {
+        return g.trans_a ? g.a[static_cast<size_t>(p) * g.lda + i] : g.a[static_cast<size_t>(i) * g.lda + p];
+    };
+    auto b_at = [&g](int p, int j) {
+        return g.trans_b ? g.b[static_cast<size_t>(j) * g.ldb + p] : g.b[static_cast<size_t>(p) * g.ldb + j];
+    };
+    SplitMix64 rng(seed ^ 0x5851f42d4c957f2dULL);
+
+    for (int i = 0; i < g.m; i++)
+    {
+        const size_t row = static_cast<size_t>(i) * g.ldc;
+        if (!std::equal(g.c + row + g.n, g.c + row + g.ldc, c0 + row + g.n))
+        {
+            std::cerr << "Erro no GEMM: folga de C (entre N e ldc) alterada na linha " << i << "\n";
+            return false;
+        }
+    }
+
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        std::vector<double> r(static_cast<size_t>(g.n));
+        std::vector<double> br(static_cast<size_t>(g.k), 0.0);
+        std::vector<double> br_abs(static_cast<size_t>(g.k), 0.0);
+        for (double &value : r)
+        {
+            value = rng.uniform();
+        }
+        for (int p = 0; p < g.k; p++)
+        {
+            for (int j = 0; j < g.n; j++)
+            {
+                br[p] += static_cast<double>(b_at(p, j)) * r[j];
+                br_abs[p] += std::fabs(static_cast<double>(b_at(p, j)) * r[j]);
+            }
+        }
+        const double epsilon = static_cast<double>(std::numeric_limits<T>::epsilon());
+        const double alpha = static_cast<double>(g.alpha);
+        const double beta = static_cast<double>(g.beta);
+        for (int i = 0; i < g.m; i++)
+        {
+            double abr = 0.0;
+            double bound = 0.0;
+            for (int p = 0; p < g.k; p++)
+            {
+                abr += static_cast<double>(a_at(i, p)) * br[p];
+                bound += std::fabs(static_cast<double>(a_at(i, p))) * br_abs[p];
+            }
+            double c0r = 0.0;
+            double c0_abs = 0.0;
+            double cr = 0.0;
+            const size_t row = static_cast<size_t>(i) * g.ldc;
+            for (int j = 0; j < g.n; j++)
+            {
+                c0r += beta == 0.0 ? 0.0 : static_cast<double>(c0[row + j]) * r[j];
+                c0_abs += beta == 0.0 ? 0.0 : std::fabs(static_cast<double>(c0[row + j]) * r[j]);
+                cr += static_cast<double>(g.c[row + j]) * r[j];
+            }
+            const double scale = std::fabs(alpha) * bound + std::fabs(beta) * c0_abs;
+            if (std::fabs(alpha * abr + beta * c0r - cr) > 2.0 * (g.k + 2.0) * epsilon * scale + 1e-300)
+            {
+                std::cerr << "Erro no GEMM " << g.m << "x" << g.n << "x" << g.k << ": Freivalds falhou na linha " << i
+                          << "\n";
+                return false;
+            }
+        }
+    }
+    else
+    {
+        auto wrap = [](T value) { return static_cast<std::uint64_t>(static_cast<std::int64_t>(value)); };
+        std::vector<std::uint64_t> r(static_cast<size_t>(g.n));
+        std::vector<std::uint64_t> br(static_cast<size_t>(g.k), 0);
+        for (std::uint64_t &value : r)
+        {
+            value = rng.next();
+        }
+        for (int p = 0; p < g.k; p++)
+        {
+            for (int j = 0; j < g.n; j++)
+            {
+                br[p] += wrap(b_at(p, j)) * r[j];
+            }
+        }
+        for (int i = 0; i < g.m; i++)
+        {
+            std::uint64_t abr = 0;
+            std::uint64_t c0r = 0;
+            std::uint64_t cr = 0;
+            for (int p = 0; p < g.k; p++)
+            {
+                abr += wrap(a_at(i, p)) * br[p];
+            }
+            const size_t row = static_cast<size_t>(i) * g.ldc;
+            for (int j = 0; j < g.n; j++)
+            {
+                c0r += g.beta == T(0) ? 0 : wrap(c0[row + j]) * r[j];
+                cr += wrap(g.c[row + j]) * r[j];
+            }
+            if (wrap(g.alpha) * abr + wrap(g.beta) * c0r != cr)
+            {
+                std::cerr << "Erro no GEMM " << g.m << "x" << g.n << "x" << g.k << ": Freivalds falhou na linha " << i
+                          << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Dimensões {M, N, K} da forma para o ponto n (veja Shape).
+static std::array<int, 3> shape_dims(Shape shape, int n, int ratio)
+{
+    const int small = std::max(1, n / ratio);
+    switch (shape)
+    {
+    case Shape::Tall:
+        return {n, small, small};
+    case Shape::Wide:
+        return {small, n, small};
+    case Shape::Inner:
+        return {small, small, n};
+    case Shape::Outer:
+        return {n, n, small};
+    case Shape::Square:
+        break;
+    }
+    return {n, n, n};
+}
+
+// rows x cols valores de --input random (mesmas faixas de fill_tile) e a
+// folga entre cols e ld preenchida com 99, que estragaria o resultado se o
+// kernel a lesse.
+template <typename T>
+static void gemm_fill(T *data, int rows, int cols, int ld, SplitMix64 &rng)
+{
+    for (int i = 0; i < rows; i++)
+    {
+        T *row = data + static_cast<size_t>(i) * ld;
+        for (int j = 0; j < cols; j++)
+        {
+            if constexpr (std::is_floating_point<T>::value)
+            {
+                row[j] = static_cast<T>(rng.uniform());
+            }
+            else
+            {
+                row[j] = static_cast<T>(static_cast<int>(rng.next() % 17) - 8);
+            }
+        }
+        std::fill(row + cols, row + ld, T(99));
+    }
+}
+
+// Modo --gemm: para cada N de make_points, cada forma e cada combinação de
+// --trans, aquecimento e M repetições de alocação e preenchimento
+// aleatório de A, B e C com --ld-pad elementos de folga por linha (TAM),
+// GEMM com --alpha/--beta (TCS), Freivalds (TVERIF) e liberação (TDM).
+template <typename T>
+static bool run_gemm_typed(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file)
+{
+    for (int point : points)
+    {
+        for (Shape shape : options.gemm_shapes)
+        {
+            const std::array<int, 3> dims = shape_dims(shape, point, options.shape_ratio);
+            for (GemmTrans trans : options.gemm_trans)
+            {
+                GemmArgs<T> g;
+                g.trans_a = trans == GemmTrans::TN || trans == GemmTrans::TT;
+                g.trans_b = trans == GemmTrans::NT || trans == GemmTrans::TT;
+                g.m = dims[0];
+                g.n = dims[1];
+                g.k = dims[2];
+                g.alpha = static_cast<T>(options.alpha);
+                g.beta = static_cast<T>(options.beta);
+                const int a_rows = g.trans_a ? g.k : g.m;
+                const int a_cols = g.trans_a ? g.m : g.k;
+                const int b_rows = g.trans_b ? g.n : g.k;
+                const int b_cols = g.trans_b ? g.k : g.n;
+                g.lda = a_cols + options.ld_pad;
+                g.ldb = b_cols + options.ld_pad;
+                g.ldc = g.n + options.ld_pad;
+
+                double time_alloc = 0.0;
+                double time_calc = 0.0;
+                double time_verify = 0.0;
+                double time_free = 0.0;
+                for (int rep = -1; rep < m_count; rep++)
+                {
+                    auto start = Clock::now();
+                    std::vector<T> a(static_cast<size_t>(a_rows) * g.lda);
+                    std::vector<T> b(static_cast<size_t>(b_rows) * g.ldb);
+                    std::vector<T> c(static_cast<size_t>(g.m) * g.ldc);
+                    SplitMix64 rng(options.seed);
+                    gemm_fill(a.data(), a_rows, a_cols, g.lda, rng);
+                    gemm_fill(b.data(), b_rows, b_cols, g.ldb, rng);
+                    gemm_fill(c.data(), g.m, g.n, g.ldc, rng);
+                    auto end = Clock::now();
+                    const double alloc = elapsed_seconds(start, end);
+                    const std::vector<T> c0(c);
+                    g.a = a.data();
+                    g.b = b.data();
+                    g.c = c.data();
+
+                    start = Clock::now();
+                    gemm(g, options);
+                    end = Clock::now();
+                    const double calc = elapsed_seconds(start, end);
+
+                    start = Clock::now();
+                    const bool ok = gemm_check(g, c0.data(), options.seed);
+                    end = Clock::now();
+                    const double verify = elapsed_seconds(start, end);
+                    if (!ok)
+                    {
+                        std::cerr << "GEMM incorreto para forma " << shape_name(shape) << " (" << gemm_trans_name(trans)
+                                  << ")\n";
+                        return false;
+                    }
+
+                    start = Clock::now();
+                    std::vector<T>().swap(a);
+                    std::vector<T>().swap(b);
+                    std::vector<T>().swap(c);
+                    end = Clock::now();
+                    if (rep >= 0)
+                    {
+                        time_alloc += alloc;
+                        time_calc += calc;
+                        time_verify += verify;
+                        time_free += elapsed_seconds(start, end);
+                    }
+                }
+
+                const double reps = static_cast<double>(m_count);
+                time_calc /= reps;
+                const double gops = 2.0 * g.m * static_cast<double>(g.n) * g.k / time_calc / 1e9;
+                file << point << "," << shape_name(shape) << "," << gemm_trans_name(trans) << ","
+                     << dtype_name(options.dtype) << "," << g.m << "," << g.n << "," << g.k << "," << time_calc << ","
+                     << (time_alloc / reps) << "," << (time_free / reps) << "," << (time_verify / reps) << "," << gops
+                     << "\n";
+            }
+        }
+        std::cout << "Formas do GEMM para N = " << point << " salvas.\n";
+    }
+    return true;
+}
+
+bool run_gemm(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file)
+{
+    file << "N,FORMA,TRANS,DTYPE,DIM_M,DIM_N,DIM_K,TCS,TAM,TDM,TVERIF,GOPS\n";
+
+    switch (options.dtype)
+    {
+    case DType::Int64:
+        return run_gemm_typed<std::int64_t>(points, options, m_count, file);
+    case DType::Float:
+        return run_gemm_typed<float>(points, options, m_count, file);
+    case DType::Double:
+        return run_gemm_typed<double>(points, options, m_count, file);
+    case DType::Int32:
+        break;
+    }
+    return run_gemm_typed<std::int32_t>(points, options, m_count, file);
+}
+
+// Modo esparso (--sparse d1,d2,...): para cada N e densidade d, mat1 tem
+// cada elemento não nulo com probabilidade d e é convertida de densa para
+// CSR. Mede SpMM (CSR x densa) contra mat2 densa e SpGEMM (CSR x CSR,
+// Gustavson com acumulador denso e colunas ordenadas) contra mat2 com a
+// mesma densidade, ambos com --threads threads em faixas de linhas (como o
+// escalonamento estático do denso), ao lado do kernel denso escolhido
+// (--kernel/--threads), medido uma vez por N porque seu custo não depende
+// dos valores. Resultados conferidos com Freivalds, fora da medição.
+struct SparseTimes
+{
+    double dense = 0.0;
+    double convert = 0.0;
+    double spmm = 0.0;
+    double spgemm = 0.0;
+};
+
+template <typename T>
+struct CsrMatrix
+{
+    int n = 0;
+    std::vector<std::int64_t> row_ptr;
+    std::vector<int> col_idx;
+    std::vector<T> values;
+
+    size_t bytes() const
+    {
+        return row_ptr.size() * sizeof(std::int64_t) + col_idx.size() * sizeof(int) + values.size() * sizeof(T);
+    }
+};
+
+template <typename T>
+static CsrMatrix<T> dense_to_csr(const T *dense, int n)
+{
+    CsrMatrix<T> csr;
+    csr.n = n;
+    csr.row_ptr.reserve(static_cast<size_t>(n) + 1);
+    csr.row_ptr.push_back(0);
+    for (int i = 0; i < n; i++)
+    {
+        const T *row = dense + static_cast<size_t>(i) * n;
+        for (int j = 0; j < n; j++)
+        {
+            if (row[j] != T(0))
+            {
+                csr.col_idx.push_back(j);
+                csr.values.push_back(row[j]);
+            }
+        }
+        csr.row_ptr.push_back(static_cast<std::int64_t>(csr.values.size()));
+    }
+    return csr;
+}
+
+template <typename T>
+static void csr_to_dense(const CsrMatrix<T> &csr, T *dense)
+{
+    const size_t n = static_cast<size_t>(csr.n);
+    std::fill(dense, dense + n * n, T(0));
+    for (size_t i = 0; i < n; i++)
+    {
+        for (std::int64_t p = csr.row_ptr[i]; p < csr.row_ptr[i + 1]; p++)
+        {
+            const size_t idx = static_cast<size_t>(p);
+            dense[i * n + static_cast<size_t>(csr.col_idx[idx])] = csr.values[idx];
+        }
+    }
+}
+
+// Linhas [begin, end) de res = mat1 (CSR) x mat2 (densa), ordem i-k-j
+// sobre os não nulos.
+template <typename T>
+static void spmm_rows(const CsrMatrix<T> &mat1, const T *mat2, T *res, size_t begin, size_t end)
+{
+    const size_t n = static_cast<size_t>(mat1.n);
+    for (size_t i = begin; i < end; i++)
+    {
+        T *res_row = res + i * n;
+        std::fill(res_row, res_row + n, T(0));
+        for (std::int64_t p = mat1.row_ptr[i]; p < mat1.row_ptr[i + 1]; p++)
+        {
+            const T a_ik = mat1.values[static_cast<size_t>(p)];
+            const T *mat2_row = mat2 + static_cast<size_t>(mat1.col_idx[static_cast<size_t>(p)]) * n;
+            for (size_t j = 0; j < n; j++)
+            {
+                res_row[j] += a_ik * mat2_row[j];
+            }
+        }
+    }
+}
+
+// A thread t calcula a t-ésima faixa de ceil(n / threads) linhas.
+template <typename T>
+static void spmm(const CsrMatrix<T> &mat1, const T *mat2, T *res, const Options &options)
+{
+    const size_t n = static_cast<size_t>(mat1.n);
+    const int threads = std::max(1, std::min(options.threads, mat1.n));
+    const size_t chunk = (n + static_cast<size_t>(threads) - 1) / static_cast<size_t>(threads);
+    run_parallel(threads, options, [&](int self) {
+        const size_t begin = std::min(n, static_cast<size_t>(self) * chunk);
+        spmm_rows(mat1, mat2, res, begin, std::min(n, begin + chunk));
+    });
+}
+
+// Linhas [begin, end) de mat1 x mat2, ambas CSR (Gustavson), em part:
+// row_ptr de part começa em 0 e tem end - begin + 1 entradas.
+template <typename T>
+static void spgemm_rows(const CsrMatrix<T> &mat1, const CsrMatrix<T> &mat2, size_t begin, size_t end,
+                        CsrMatrix<T> &part)
+{
+    const size_t n = static_cast<size_t>(mat1.n);
+    part.n = mat1.n;
+    part.row_ptr.assign(1, 0);
+    std::vector<T> accumulator(n, T(0));
+    std::vector<std::int64_t> marker(n, -1);
+    std::vector<int> touched;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        touched.clear();
+        for (std::int64_t p = mat1.row_ptr[i]; p < mat1.row_ptr[i + 1]; p++)
+        {
+            const T a_ik = mat1.values[static_cast<size_t>(p)];
+            const size_t k = static_cast<size_t>(mat1.col_idx[static_cast<size_t>(p)]);
+            for (std::int64_t q = mat2.row_ptr[k]; q < mat2.row_ptr[k + 1]; q++)
+            {
+                const int j = mat2.col_idx[static_cast<size_t>(q)];
+                if (marker[static_cast<size_t>(j)] != static_cast<std::int64_t>(i))
+                {
+                    marker[static_cast<size_t>(j)] = static_cast<std::int64_t>(i);
+                    accumulator[static_cast<size_t>(j)] = T(0);
+                    touched.push_back(j);
+                }
+                accumulator[static_cast<size_t>(j)] += a_ik * mat2.values[static_cast<size_t>(q)];
+            }
+        }
+        std::sort(touched.begin(), touched.end());
+        for (int j : touched)
+        {
+            part.col_idx.push_back(j);
+            part.values.push_back(accumulator[static_cast<size_t>(j)]);
+        }
+        part.row_ptr.push_back(static_cast<std::int64_t>(part.values.size()));
+    }
+}
+
+// res = mat1 x mat2, ambas CSR. Cada thread calcula sua faixa de linhas em
+// uma CSR parcial; depois de somar os tamanhos, cada uma copia a sua para a
+// posição final.
+template <typename T>
+static CsrMatrix<T> spgemm(const CsrMatrix<T> &mat1, const CsrMatrix<T> &mat2, const Options &options)
+{
+    const size_t n = static_cast<size_t>(mat1.n);
+    const int threads = std::max(1, std::min(options.threads, mat1.n));
+    const size_t chunk = (n + static_cast<size_t>(threads) - 1) / static_cast<size_t>(threads);
+    std::vector<CsrMatrix<T>> parts(static_cast<size_t>(threads));
+    run_parallel(threads, options, [&](int self) {
+        const size_t begin = std::min(n, static_cast<size_t>(self) * chunk);
+        spgemm_rows(mat1, mat2, begin, std::min(n, begin + chunk), parts[static_cast<size_t>(self)]);
+    });
+
+    std::vector<std::int64_t> offsets(static_cast<size_t>(threads) + 1, 0);
+    for (size_t t = 0; t < parts.size(); t++)
+    {
+        offsets[t + 1] = offsets[t] + parts[t].row_ptr.back();
+    }
+    CsrMatrix<T> res;
+    res.n = mat1.n;
+    res.row_ptr.resize(n + 1);
+    res.row_ptr[0] = 0;
+    res.col_idx.resize(static_cast<size_t>(offsets.back()));
+    res.values.resize(static_cast<size_t>(offsets.back()));
+    run_parallel(threads, options, [&](int self) {
+        const CsrMatrix<T> &part = parts[static_cast<size_t>(self)];
+        const size_t begin = std::min(n, static_cast<size_t>(self) * chunk);
+        const std::int64_t offset = offsets[static_cast<size_t>(self)];
+        for (size_t r = 1; r < part.row_ptr.size(); r++)
+        {
+            res.row_ptr[begin + r] = offset + part.row_ptr[r];
+        }
+        std::copy(part.col_idx.begin(), part.col_idx.end(), res.col_idx.begin() + offset);
+        std::copy(part.values.begin(), part.values.end(), res.values.begin() + offset);
+    });
+    return res;
+}
+
+// Matriz N x N com cada elemento não nulo com probabilidade density,
+// valores nas faixas de --input random (sem zero para inteiros).
+template <typename T>
+static void fill_sparse(T *dense, int n, double density, SplitMix64 &rng)
+{
+    const size_t count = static_cast<size_t>(n) * n;
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        const bool nonzero = (rng.uniform() + 1.0) * 0.5 < density;
+        if (!nonzero)
+        {
+            dense[idx] = T(0);
+        }
+        else if constexpr (std::is_floating_point<T>::value)
+        {
+            dense[idx] = static_cast<T>(rng.uniform());
+        }
+        else
+        {
+            const int value = static_cast<int>(rng.next() % 16) - 8;
+            dense[idx] = static_cast<T>(value >= 0 ? value + 1 : value);
+        }
+    }
+}
+
+template <typename T>
+static bool run_sparse_typed(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file)
+{
+    for (int n : points)
+    {
+        const size_t n2 = static_cast<size_t>(n) * n;
+        std::vector<T> mat1(n2);
+        std::vector<T> mat2_dense(n2);
+        std::vector<T> mat2_sparse(n2);
+        std::vector<T> res(n2);
+        SplitMix64 rng(options.seed);
+        for (T &value : mat2_dense)
+        {
+            value = std::is_floating_point<T>::value ? static_cast<T>(rng.uniform())
+                                                     : static_cast<T>(static_cast<int>(rng.next() % 17) - 8);
+        }
+
+        double time_dense = 0.0;
+        for (size_t d = 0; d < options.sparse.size(); d++)
+        {
+            const double density = options.sparse[d];
+            fill_sparse(mat1.data(), n, density, rng);
+            fill_sparse(mat2_sparse.data(), n, density, rng);
+
+            if (d == 0)
+            {
+                for (int rep = -1; rep < m_count; rep++)
+                {
+                    const auto start = Clock::now();
+                    run_kernel(mat1.data(), mat2_dense.data(), res.data(), n, options, nullptr);
+                    if (rep >= 0)
+                    {
+                        time_dense += elapsed_seconds(start, Clock::now());
+                    }
+                }
+                time_dense /= static_cast<double>(m_count);
+                if (!freivalds(mat1.data(), mat2_dense.data(), res.data(), n, options.seed))
+                {
+                    return false;
+                }
+            }
+
+            SparseTimes times;
+            CsrMatrix<T> csr1;
+            CsrMatrix<T> csr2;
+            CsrMatrix<T> product;
+            for (int rep = -1; rep < m_count; rep++)
+            {
+                auto start = Clock::now();
+                csr1 = dense_to_csr(mat1.data(), n);
+                auto end = Clock::now();
+                csr2 = dense_to_csr(mat2_sparse.data(), n);
+                if (rep >= 0)
+                {
+                    times.convert += elapsed_seconds(start, end);
+                }
+
+                start = Clock::now();
+                spmm(csr1, mat2_dense.data(), res.data(), options);
+                end = Clock::now();
+                if (rep >= 0)
+                {
+                    times.spmm += elapsed_seconds(start, end);
+                }
+
+                start = Clock::now();
+                product = spgemm(csr1, csr2, options);
+                end = Clock::now();
+                if (rep >= 0)
+                {
+                    times.spgemm += elapsed_seconds(start, end);
+                }
+            }
+
+            if (!freivalds(mat1.data(), mat2_dense.data(), res.data(), n, options.seed))
+            {
+                std::cerr << "SpMM incorreto para densidade " << density << "\n";
+                return false;
+            }
+            csr_to_dense(product, res.data());
+            if (!freivalds(mat1.data(), mat2_sparse.data(), res.data(), n, options.seed))
+            {
+                std::cerr << "SpGEMM incorreto para densidade " << density << "\n";
+                return false;
+            }
+
+            const double reps = static_cast<double>(m_count);
+            times.convert /= reps;
+            times.spmm /= reps;
+            times.spgemm /= reps;
+            file << n << "," << csr1.values.size() << "," << density << "," << product.values.size() << ","
+                 << time_dense << "," << times.convert << "," << times.spmm << "," << times.spgemm << ","
+                 << (time_dense / times.spmm) << "," << (time_dense / times.spgemm) << "," << (n2 * sizeof(T)) << ","
+                 << csr1.bytes() << "\n";
+        }
+
+        std::cout << "Varredura esparsa para N = " << n << " salva.\n";
+    }
+
+    return true;
+}
+
+bool run_sparse(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file)
+{
+    file << "N,NNZ,DENSIDADE,NNZ_RES,T_DENSO,T_CONVERSAO,T_SPMM,T_SPGEMM,GANHO_SPMM,GANHO_SPGEMM,BYTES_DENSO,"
+            "BYTES_CSR\n";
+
+    switch (options.dtype)
+    {
+    case DType::Int64:
+        return run_sparse_typed<std::int64_t>(points, options, m_count, file);
+    case DType::Float:
+        return run_sparse_typed<float>(points, options, m_count, file);
+    case DType::Double:
+        return run_sparse_typed<double>(points, options, m_count, file);
+    case DType::Int32:
+        break;
+    }
+    return run_sparse_typed<std::int32_t>(points, options, m_count, file);
+}
+
+// Modo distribuído (--distributed P): P = q x q processos criados com fork()
+// formam uma grade 2-D; o processo (i, j) tem em memória própria os blocos
+// A_ij, B_ij e C_ij de lado ceil(N / q) (com zeros além de N). Os blocos
+// trafegam por caixas postais em memória compartilhada (mmap anônimo
+// MAP_SHARED) e cada passo é fechado por uma barreira pthread
+// compartilhada entre processos:
+//  - summa: no passo k, o dono de A_ik publica o bloco para a linha i e o
+//    dono de B_kj para a coluna j; os demais copiam e acumulam A_ik B_kj;
+//  - cannon: alinhamento inicial (A da linha i desloca i à esquerda, B da
+//    coluna j desloca j para cima) e q passos de produto seguido de
+//    deslocamento de 1 bloco.
+// Por processo: T_COMPUTO é o produto dos blocos (kernel i-k-j do modo
+// fora do núcleo), T_COMUNICACAO são as cópias de/para a memória
+// compartilhada, T_SINCRONIZACAO é a espera nas barreiras (desequilíbrio)
+// e BYTES soma o que o processo enviou e recebeu.
+#ifdef MATRIZ_MMAP
+struct DistStats
+{
+    double wall = 0.0;
+    double compute = 0.0;
+    double comm = 0.0;
+    double sync = 0.0;
+    double bytes = 0.0;
+    int ok = 0;
+};
+
+// Região anônima MAP_SHARED, herdada pelos processos filhos no fork().
+class SharedRegion
+{
+public:
+    explicit SharedRegion(size_t bytes) : bytes_(std::max<size_t>(bytes, 1))
+    {
+        void *data = ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Erro ao criar memoria compartilhada para --distributed");
+        }
+        data_ = static_cast<char *>(data);
+    }
+
+    SharedRegion(const SharedRegion &) = delete;
+    SharedRegion &operator=(const SharedRegion &) = delete;
+
+    ~SharedRegion()
+    {
+        ::munmap(data_, bytes_);
+    }
+
+    char *data() const
+    {
+        return data_;
+    }
+
+private:
+    size_t bytes_;
+    char *data_ = nullptr;
+};
+
+// Deslocamentos dentro da região: barreira, estatísticas por processo,
+// 2 P caixas postais de um bloco e res N x N (reunido no fim, fora do tempo).
+struct DistLayout
+{
+    int q = 1;
+    int block = 1;
+    size_t block_elems = 1;
+    size_t stats = 0;
+    size_t slots = 0;
+    size_t res = 0;
+    size_t bytes = 0;
+};
+
+static size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+static DistLayout dist_layout(int n, int procs)
+{
+    DistLayout layout;
+    layout.q = static_cast<int>(std::lround(std::sqrt(static_cast<double>(procs))));
+    layout.block = (n + layout.q - 1) / layout.q;
+    layout.block_elems = static_cast<size_t>(layout.block) * layout.block;
+    layout.stats = align_up(sizeof(pthread_barrier_t), 64);
+    layout.slots = align_up(layout.stats + sizeof(DistStats) * procs, 64);
+    layout.res = align_up(layout.slots + 2 * static_cast<size_t>(procs) * layout.block_elems * sizeof(T), 64);
+    layout.bytes = layout.res + static_cast<size_t>(n) * n * sizeof(T);
+    return layout;
+}
+
+// Copia o bloco (row, col) de lado block de uma matriz N x N, com zeros fora.
+template <typename T>
+static void load_block(const T *matrix, int n, int row, int col, int block, T *out)
+{
+    for (int i = 0; i < block; i++)
+    {
+        const int gi = row * block + i;
+        for (int j = 0; j < block; j++)
+        {
+            const int gj = col * block + j;
+            out[static_cast<size_t>(i) * block + j] =
+                (gi < n && gj < n) ? matrix[static_cast<size_t>(gi) * n + gj] : T(0);
+        }
+    }
+}
+
+// Corpo de um processo da grade; roda no filho após o fork().
+template <typename T>
+static void dist_worker(int rank, int procs, const DistLayout &layout, const T *mat1, const T *mat2, int n,
+                        DistAlgorithm algorithm, char *shared)
+{
+    pthread_barrier_t *barrier = reinterpret_cast<pthread_barrier_t *>(shared);
+    DistStats &stats = reinterpret_cast<DistStats *>(shared + layout.stats)[rank];
+    T *slots = reinterpret_cast<T *>(shared + layout.slots);
+    T *res = reinterpret_cast<T *>(shared + layout.res);
+    const int q = layout.q;
+    const int block = layout.block;
+    const size_t elems = layout.block_elems;
+    const int row = rank / q;
+    const int col = rank % q;
+
+    std::vector<T> a(elems);
+    std::vector<T> b(elems);
+    std::vector<T> c(elems, T(0));
+    std::vector<T> a_in(elems);
+    std::vector<T> b_in(elems);
+    load_block(mat1, n, row, col, block, a.data());
+    load_block(mat2, n, row, col, block, b.data());
+
+    auto wait = [&]() {
+        const auto start = Clock::now();
+        pthread_barrier_wait(barrier);
+        stats.sync += elapsed_seconds(start, Clock::now());
+    };
+    auto send = [&](const std::vector<T> &from, int slot) {
+        const auto start = Clock::now();
+        std::copy(from.begin(), from.end(), slots + slot * elems);
+        stats.comm += elapsed_seconds(start, Clock::now());
+        stats.bytes += static_cast<double>(elems * sizeof(T));
+    };
+    auto receive = [&](int slot, std::vector<T> &to) {
+        const auto start = Clock::now();
+        std::copy(slots + slot * elems, slots + (slot + 1) * elems, to.begin());
+        stats.comm += elapsed_seconds(start, Clock::now());
+        stats.bytes += static_cast<double>(elems * sizeof(T));
+    };
+    auto multiply = [&](const T *x, const T *y) {
+        const auto start = Clock::now();
+        panel_multiply(x, y, c.data(), block, block, block);
+        stats.compute += elapsed_seconds(start, Clock::now());
+    };
+
+    // Todos com os blocos carregados antes de o tempo começar.
+    pthread_barrier_wait(barrier);
+    const auto start = Clock::now();
+    if (algorithm == DistAlgorithm::Summa)
+    {
+        // Caixas 0..q-1: painel de A de cada linha; q..2q-1: de B de cada coluna.
+        for (int k = 0; k < q; k++)
+        {
+            if (col == k)
+            {
+                send(a, row);
+            }
+            if (row == k)
+            {
+                send(b, q + col);
+            }
+            wait();
+            if (col != k)
+            {
+                receive(row, a_in);
+            }
+            if (row != k)
+            {
+                receive(q + col, b_in);
+            }
+            multiply(col == k ? a.data() : a_in.data(), row == k ? b.data() : b_in.data());
+            wait();
+        }
+    }
+    else
+    {
+        // Caixas 0..P-1: bloco de A de cada processo; P..2P-1: de B. Só copia
+        // quem de fato troca de bloco; as barreiras são de todos.
+        auto shift = [&](int a_from, int b_from) {
+            if (a_from != rank)
+            {
+                send(a, rank);
+            }
+            if (b_from != rank)
+            {
+                send(b, procs + rank);
+            }
+            wait();
+            if (a_from != rank)
+            {
+                receive(a_from, a);
+            }
+            if (b_from != rank)
+            {
+                receive(procs + b_from, b);
+            }
+            wait();
+        };
+        shift(row * q + (col + row) % q, ((row + col) % q) * q + col);
+        for (int step = 0; step < q; step++)
+        {
+            multiply(a.data(), b.data());
+            if (step + 1 < q)
+            {
+                shift(row * q + (col + 1) % q, ((row + 1) % q) * q + col);
+            }
+        }
+    }
+    wait();
+    stats.wall = elapsed_seconds(start, Clock::now());
+
+    for (int i = 0; i < block && row * block + i < n; i++)
+    {
+        const int gi = row * block + i;
+        const int count = std::min(block, n - col * block);
+        std::copy(c.begin() + static_cast<size_t>(i) * block, c.begin() + static_cast<size_t>(i) * block + count,
+                  res + static_cast<size_t>(gi) * n + col * block);
+    }
+    stats.ok = 1;
+}
+
+// Uma repetição: cria os P processos (o de posto r preso como a thread r de
+// --pin), espera todos e mata os restantes se algum falhar (os outros
+// ficariam presos na barreira).
+template <typename T>
+static bool dist_run(int procs, const DistLayout &layout, const T *mat1, const T *mat2, int n,
+                     const Options &options, char *shared)
+{
+    DistStats *stats = reinterpret_cast<DistStats *>(shared + layout.stats);
+    std::fill(stats, stats + procs, DistStats());
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> children;
+    bool ok = true;
+    for (int rank = 0; rank < procs && ok; rank++)
+    {
+        const pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            int code = 1;
+            try
+            {
+                pin_thread(options, rank);
+                dist_worker(rank, procs, layout, mat1, mat2, n, options.dist_algorithm, shared);
+                code = 0;
+            }
+            catch (...)
+            {
+            }
+            ::_exit(code);
+        }
+        if (pid < 0)
+        {
+            std::cerr << "Erro ao criar processo para --distributed (fork)\n";
+            ok = false;
+        }
+        else
+        {
+            children.push_back(pid);
+        }
+    }
+
+    size_t running = children.size();
+    if (!ok)
+    {
+        for (pid_t pid : children)
+        {
+            ::kill(pid, SIGKILL);
+        }
+    }
+    while (running > 0)
+    {
+        int status = 0;
+        const pid_t pid = ::waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            break;
+        }
+        running--;
+        if (ok && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+        {
+            std::cerr << "Processo " << pid << " de --distributed falhou\n";
+            ok = false;
+            for (pid_t other : children)
+            {
+                ::kill(other, SIGKILL);
+            }
+        }
+    }
+    for (int rank = 0; ok && rank < procs; rank++)
+    {
+        ok = stats[rank].ok == 1;
+    }
+    return ok;
+}
+
+template <typename T>
+static bool run_distributed_typed(const std::vector<int> &points, const Options &options, int m_count,
+                                  std::ofstream &file)
+{
+    const int procs = options.distributed;
+    for (int n : points)
+    {
+        const size_t n2 = static_cast<size_t>(n) * n;
+        std::vector<T> mat1(n2);
+        std::vector<T> mat2(n2);
+        fill_inputs(mat1.data(), mat2.data(), n, options);
+
+        const DistLayout layout = dist_layout<T>(n, procs);
+        SharedRegion region(layout.bytes);
+        pthread_barrier_t *barrier = reinterpret_cast<pthread_barrier_t *>(region.data());
+        pthread_barrierattr_t attr;
+        pthread_barrierattr_init(&attr);
+        pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        const bool barrier_ok = pthread_barrier_init(barrier, &attr, static_cast<unsigned>(procs)) == 0;
+        pthread_barrierattr_destroy(&attr);
+        if (!barrier_ok)
+        {
+            std::cerr << "Erro ao criar barreira entre processos para --distributed\n";
+            return false;
+        }
+
+        const DistStats *stats = reinterpret_cast<const DistStats *>(region.data() + layout.stats);
+        std::vector<DistStats> totals(procs);
+        bool ok = true;
+        for (int rep = -1; rep < m_count && ok; rep++)
+        {
+            ok = dist_run(procs, layout, mat1.data(), mat2.data(), n, options, region.data());
+            for (int rank = 0; ok && rep >= 0 && rank < procs; rank++)
+            {
+                totals[rank].wall += stats[rank].wall;
+                totals[rank].compute += stats[rank].compute;
+                totals[rank].comm += stats[rank].comm;
+                totals[rank].sync += stats[rank].sync;
+                totals[rank].bytes += stats[rank].bytes;
+            }
+        }
+        pthread_barrier_destroy(barrier);
+        if (!ok || !freivalds(mat1.data(), mat2.data(), reinterpret_cast<const T *>(region.data() + layout.res), n,
+                              options.seed))
+        {
+            return false;
+        }
+
+        const double reps = static_cast<double>(m_count);
+        for (int rank = 0; rank < procs; rank++)
+        {
+            file << n << "," << procs << "," << rank << "," << (totals[rank].wall / reps) << ","
+                 << (totals[rank].compute / reps) << "," << (totals[rank].comm / reps) << ","
+                 << (totals[rank].sync / reps) << "," << (totals[rank].bytes / reps) << "\n";
+        }
+        std::cout << "Multiplicacao distribuida (" << dist_algorithm_name(options.dist_algorithm) << ", " << layout.q
+                  << "x" << layout.q << " processos) para N = " << n << " salva.\n";
+    }
+
+    return true;
+}
+
+bool run_distributed(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file)
+{
+    file << "N,PROCESSOS,RANK,T_TOTAL,T_COMPUTO,T_COMUNICACAO,T_SINCRONIZACAO,BYTES\n";
+
+    switch (options.dtype)
+    {
+    case DType::Int64:
+        return run_distributed_typed<std::int64_t>(points, options, m_count, file);
+    case DType::Float:
+        return run_distributed_typed<float>(points, options, m_count, file);
+    case DType::Double:
+        return run_distributed_typed<double>(points, options, m_count, file);
+    case DType::Int32:
+        break;
+    }
+    return run_distributed_typed<std::int32_t>(points, options, m_count, file);
+}
+#endif
+
+// Roofline (--roofline): banda de memória (tríade estilo STREAM) e pico de
+// computação medidos uma vez na inicialização, com o mesmo número de threads
+// do kernel. Cada ponto é posicionado pela intensidade aritmética mínima
+// 2N^3 / (3 N^2 sizeof(T)), a de um cache ideal que lê mat1 e mat2 e
+// escreve res uma única vez.
+struct Roofline
+{
+    double bandwidth_gbs = 0.0;
+    double peak_gops = 0.0;
+    Isa peak_isa = Isa::Scalar;
+    int threads = 1;
+};
+
+struct RooflinePoint
+{
+    int n = 0;
+    double gops = 0.0;
+    double intensity = 0.0;
+    double roof_gops = 0.0;
+};
+
+static const size_t kStreamElements = static_cast<size_t>(1) << 24;
+static const long long kPeakIterations = 1LL << 22;
+
+// Executa work(t) em threads e devolve o tempo de parede.
+static double parallel_seconds(int threads, const Options &options, const std::function<void(int)> &work)
+{
+    const auto start = Clock::now();
+    run_parallel(threads, options, work);
+    return elapsed_seconds(start, Clock::now());
+}
+
+// Tríade a[i] = b[i] + s * c[i] em double; cada thread inicializa (primeiro
+// toque) e percorre a própria fatia. Vale a melhor de 5 passadas, contando
+// 3 * 8 bytes por elemento, como no STREAM.
+static double stream_bandwidth(int threads, const Options &options)
+{
+    std::unique_ptr<double[]> a(new double[kStreamElements]);
+    std::unique_ptr<double[]> b(new double[kStreamElements]);
+    std::unique_ptr<double[]> c(new double[kStreamElements]);
+    const size_t chunk = (kStreamElements + static_cast<size_t>(threads) - 1) / static_cast<size_t>(threads);
+    const auto slice = [&](int t, size_t &begin, size_t &end) {
+        begin = std::min(kStreamElements, chunk * static_cast<size_t>(t));
+        end = std::min(kStreamElements, begin + chunk);
+    };
+
+    parallel_seconds(threads, options, [&](int t) {
+        size_t begin = 0;
+        size_t end = 0;
+        slice(t, begin, end);
+        for (size_t i = begin; i < end; i++)
+        {
+            a[i] = 0.0;
+            b[i] = 1.0;
+            c[i] = 2.0;
+        }
+    });
+
+    volatile double scalar_seed = 3.0;
+    const double scalar = scalar_seed;
+    double best = std::numeric_limits<double>::infinity();
+    for (int pass = 0; pass < 5; pass++)
+    {
+        best = std::min(best, parallel_seconds(threads, options, [&](int t) {
+            size_t begin = 0;
+            size_t end = 0;
+            slice(t, begin, end);
+            for (size_t i = begin; i < end; i++)
+            {
+                a[i] = b[i] + scalar * c[i];
+            }
+        }));
+    }
+    if (a[kStreamElements / 2] != 7.0)
+    {
+        std::cerr << "Aviso: triade STREAM com resultado inesperado.\n";
+    }
+    return 3.0 * sizeof(double) * static_cast<double>(kStreamElements) / best * 1e-9;
+}
+
+// Versão sem SIMD explícito (int64, ou CPU sem SSE4.1): o compilador pode
+// vetorizar com o ISA base do binário.
+template <typename T>
+static double peak_scalar(T up, T down, long long iterations, T *sink)
+{
+    T acc[12];
+    for (int a = 0; a < 12; a++)
+    {
+        acc[a] = static_cast<T>(a + 1);
+    }
+    for (long long it = 0; it < iterations; it++)
+    {
+        for (int a = 0; a < 12; a++)
+        {
+            acc[a] += acc[a] * up;
+        }
+        for (int a = 0; a < 12; a++)
+        {
+            acc[a] += acc[a] * down;
+        }
+    }
+    std::copy(acc, acc + 12, sink);
+    return static_cast<double>(iterations) * 2.0 * 12.0 * 2.0;
+}
+
+template <typename T>
+static double peak_ops(Isa isa, T up, T down, long long iterations, T *sink)
+{
+    if constexpr (!std::is_same<T, std::int64_t>::value)
+    {
+        switch (isa)
+        {
+#ifdef MATRIZ_X86_SIMD
+        case Isa::Sse41:
+            return peak_sse41(up, down, iterations, sink);
+        case Isa::Avx2:
+            return peak_avx2(up, down, iterations, sink);
+        case Isa::Avx512:
+            return peak_avx512(up, down, iterations, sink);
+#endif
+        default:
+            break;
+        }
+    }
+    return peak_scalar(up, down, iterations, sink);
+}
+
+// Melhor de 3 passadas, somando as operações de todas as threads.
+template <typename T>
+static double peak_gops(Isa isa, int threads, const Options &options)
+{
+    // Lidos de volatile para o compilador não dobrar acc * up em constante.
+    // Com up = 1 e down = -1 os inteiros zerariam no primeiro passo.
+    volatile double up_seed = std::is_floating_point<T>::value ? 1e-3 : -2.0;
+    volatile double down_seed = std::is_floating_point<T>::value ? -1e-3 : -2.0;
+    const T up = static_cast<T>(up_seed);
+    const T down = static_cast<T>(down_seed);
+    std::vector<T> sink(static_cast<size_t>(threads) * 12 * 16);
+    std::vector<double> ops(static_cast<size_t>(threads));
+
+    double best = 0.0;
+    for (int pass = 0; pass < 3; pass++)
+    {
+        const double seconds = parallel_seconds(threads, options, [&](int t) {
+            ops[static_cast<size_t>(t)] =
+                peak_ops(isa, up, down, kPeakIterations, sink.data() + static_cast<size_t>(t) * 12 * 16);
+        });
+        double total = 0.0;
+        for (double count : ops)
+        {
+            total += count;
+        }
+        best = std::max(best, total / seconds * 1e-9);
+    }
+    return best;
+}
+
+// O pico usa o maior ISA da CPU para o tipo, não o do kernel escolhido:
+// o teto é o da máquina.
+static Roofline measure_roofline(const Options &options, Isa detected)
+{
+    Roofline roof;
+    roof.threads = std::max(1, options.threads);
+    roof.peak_isa = options.dtype == DType::Int64 ? Isa::Scalar : detected;
+    roof.bandwidth_gbs = stream_bandwidth(roof.threads, options);
+    switch (options.dtype)
+    {
+    case DType::Int64:
+        roof.peak_gops = peak_gops<std::int64_t>(roof.peak_isa, roof.threads, options);
+        break;
+    case DType::Float:
+        roof.peak_gops = peak_gops<float>(roof.peak_isa, roof.threads, options);
+        break;
+    case DType::Double:
+        roof.peak_gops = peak_gops<double>(roof.peak_isa, roof.threads, options);
+        break;
+    case DType::Int32:
+        roof.peak_gops = peak_gops<std::int32_t>(roof.peak_isa, roof.threads, options);
+        break;
+    }
+    return roof;
+}
+
+static RooflinePoint place_point(const Roofline &roof, int n, double time_calc, DType dtype)
+{
+    RooflinePoint point;
+    const double nd = static_cast<double>(n);
+    point.n = n;
+    point.gops = 2.0 * nd * nd * nd / time_calc * 1e-9;
+    point.intensity = 2.0 * nd / (3.0 * static_cast<double>(dtype_size(dtype)));
+    point.roof_gops = std::min(roof.peak_gops, point.intensity * roof.bandwidth_gbs);
+    return point;
+}
+
+static bool write_roofline_json(const std::string &path, const Roofline &roof, const Options &options,
+                                const std::vector<RooflinePoint> &points)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Erro ao abrir arquivo de roofline: " << path << "\n";
+        return false;
+    }
+
+    file << std::setprecision(6);
+    file << "{\n"
+         << "  \"kernel\": " << json_string(kernel_name(options.kernel)) << ",\n"
+         << "  \"dtype\": " << json_string(dtype_name(options.dtype)) << ",\n"
+         << "  \"threads\": " << roof.threads << ",\n"
+         << "  \"bandwidth_gbs\": " << roof.bandwidth_gbs << ",\n"
+         << "  \"peak_gops\": " << roof.peak_gops << ",\n"
+         << "  \"peak_isa\": " << json_string(isa_name(roof.peak_isa)) << ",\n"
+         << "  \"ridge_intensity\": " << (roof.peak_gops / roof.bandwidth_gbs) << ",\n"
+         << "  \"points\": [";
+    for (size_t p = 0; p < points.size(); p++)
+    {
+        const RooflinePoint &point = points[p];
+        file << (p == 0 ? "\n" : ",\n") << "    {\"n\": " << point.n << ", \"gops\": " << point.gops
+             << ", \"intensity\": " << point.intensity << ", \"roof_gops\": " << point.roof_gops
+             << ", \"fraction\": " << (point.gops / point.roof_gops) << ", \"bound\": "
+             << json_string(point.intensity * roof.bandwidth_gbs < roof.peak_gops ? "memoria" : "computacao")
+             << "}";
+    }
+    file << (points.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    return true;
+}
+
+// Modo de THP do sistema (o valor entre colchetes em
+// /sys/kernel/mm/transparent_hugepage/enabled), ou N/A fora do Linux.
+static std::string thp_mode()
+{
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string line;
+    if (!std::getline(file, line))
+    {
+        return "N/A";
+    }
+    const size_t open = line.find('[');
+    const size_t close = line.find(']', open);
+    if (open == std::string::npos || close == std::string::npos)
+    {
+        return "N/A";
+    }
+    return line.substr(open + 1, close - open - 1);
+}
+
+bool write_meta_json(const Options &options, Isa detected, const std::string &cpu,
+                     const std::vector<TuneEntry> &tuning)
+{
+    std::ofstream file(options.meta_json);
+    if (!file.is_open())
+    {
+        std::cerr << "Erro ao abrir arquivo de metadados: " << options.meta_json << "\n";
+        return false;
+    }
+
+    file << "{\n"
+         << "  \"kernel\": " << json_string(kernel_name(options.kernel)) << ",\n"
+         << "  \"dtype\": " << json_string(dtype_name(options.dtype)) << ",\n"
+         << "  \"alloc\": " << json_string(alloc_name(options.alloc)) << ",\n"
+         << "  \"input\": " << json_string(options.input == Input::Random ? "random" : "identity") << ",\n"
+         << "  \"seed\": " << options.seed << ",\n"
+         << "  \"verify\": " << json_string(options.verify == Verify::Freivalds ? "freivalds" : "sample") << ",\n"
+         << "  \"thp\": " << json_string(thp_mode()) << ",\n"
+         << "  \"isa\": " << json_string(uses_isa(options.kernel) ? isa_name(options.isa) : "N/A") << ",\n"
+         << "  \"isa_detected\": " << json_string(isa_name(detected)) << ",\n"
+         << "  \"tile_i\": " << options.tile_i << ",\n"
+         << "  \"tile_j\": " << options.tile_j << ",\n"
+         << "  \"tile_k\": " << options.tile_k << ",\n"
+         << "  \"strassen_cutoff\": " << options.strassen_cutoff << ",\n"
+         << "  \"threads\": " << options.threads << ",\n"
+         << "  \"schedule\": " << json_string(options.schedule == Schedule::Steal ? "steal" : "static") << ",\n"
+         << "  \"init\": " << json_string(options.init == InitMode::Parallel ? "parallel" : "serial") << ",\n"
+         << "  \"pin\": " << json_string(pin_name(options.pin)) << ",\n"
+         << "  \"pin_cpus\": [" << json_int_list(options.pin_cpus) << "],\n"
+         << "  \"pin_nodes\": [" << json_int_list(pin_nodes(options.pin_cpus)) << "],\n"
+         << "  \"max_threads\": " << options.max_threads << ",\n"
+         << "  \"batch\": " << options.batch << ",\n"
+         << "  \"sweep_kernels\": [";
+    for (size_t k = 0; k < options.sweep_kernels.size(); k++)
+    {
+        file << (k == 0 ? "" : ", ") << json_string(kernel_name(options.sweep_kernels[k]));
+    }
+    file << "],\n"
+         << "  \"sweep_dtypes\": [";
+    for (size_t d = 0; d < options.sweep_dtypes.size(); d++)
+    {
+        file << (d == 0 ? "" : ", ") << json_string(dtype_name(options.sweep_dtypes[d]));
+    }
+    file << "],\n"
+         << "  \"sparse\": [";
+    for (size_t d = 0; d < options.sparse.size(); d++)
+    {
+        file << (d == 0 ? "" : ", ") << options.sparse[d];
+    }
+    file << "],\n"
+         << "  \"mat1\": " << json_string(options.mat1.empty() ? "N/A" : options.mat1) << ",\n"
+         << "  \"mat2\": " << json_string(options.mat2.empty() ? "N/A" : options.mat2) << ",\n"
+         << "  \"res_out\": " << json_string(options.res_out.empty() ? "N/A" : options.res_out) << ",\n"
+         << "  \"ooc_dir\": " << json_string(options.ooc_dir.empty() ? "N/A" : options.ooc_dir) << ",\n"
+         << "  \"ooc_mem_mib\": " << options.ooc_mem << ",\n"
+         << "  \"distributed\": " << options.distributed << ",\n"
+         << "  \"dist_algorithm\": " << json_string(dist_algorithm_name(options.dist_algorithm)) << ",\n"
+         << "  \"gemm_shapes\": [";
+    for (size_t s = 0; s < options.gemm_shapes.size(); s++)
+    {
+        file << (s == 0 ? "" : ", ") << json_string(shape_name(options.gemm_shapes[s]));
+    }
+    file << "],\n"
+         << "  \"gemm_trans\": [";
+    for (size_t t = 0; t < options.gemm_trans.size(); t++)
+    {
+        file << (t == 0 ? "" : ", ") << json_string(gemm_trans_name(options.gemm_trans[t]));
+    }
+    file << "],\n"
+         << "  \"alpha\": " << options.alpha << ",\n"
+         << "  \"beta\": " << options.beta << ",\n"
+         << "  \"ld_pad\": " << options.ld_pad << ",\n"
+         << "  \"shape_ratio\": " << options.shape_ratio << ",\n"
+#ifdef MATRIZ_BLAS
+         << "  \"blas\": " << json_string(blas_library()) << ",\n"
+#else
+         << "  \"blas\": \"N/A\",\n"
+#endif
+         << "  \"cpu_model\": " << json_string(cpu) << ",\n"
+         << "  \"tune_cache\": " << json_string(options.tune_cache.empty() ? "N/A" : options.tune_cache) << ",\n"
+         << "  \"tuning\": [";
+    file << std::scientific << std::setprecision(6);
+    for (size_t e = 0; e < tuning.size(); e++)
+    {
+        file << (e == 0 ? "\n" : ",\n");
+        write_tune_entry(file, tuning[e], "    ");
+    }
+    file << (tuning.empty() ? "]\n" : "\n  ]\n") << "}\n";
+    return true;
+}
+
+// CSV padrão: uma linha por N com TCS, TAM e TDM e as colunas opcionais do
+// kernel e das opções; --roofline mede os tetos antes da varredura.
+bool run_standard(const std::vector<int> &points, const Options &options,
+                  const std::vector<TuneEntry> &tuning, int m_count, Isa detected, std::ofstream &file,
+                  std::ofstream *stats_file, std::ofstream *perf_file, std::ofstream *samples_file)
+{
+    const bool isa_column = uses_isa(options.kernel);
+    const bool mem_column = options.kernel == Kernel::Strassen || options.kernel == Kernel::Morton ||
+                            options.kernel == Kernel::Packed;
+    const bool convert_column = options.kernel == Kernel::Morton;
+    const bool pack_column = options.kernel == Kernel::Packed;
+    const bool dtype_column = options.dtype != DType::Int32;
+    const bool alloc_column = options.alloc != AllocPolicy::Vector;
+    const bool verify_column = options.verify == Verify::Freivalds;
+    const bool ooc_columns = !options.ooc_dir.empty();
+    const bool stats_columns = samples_file != nullptr || options.ci_target > 0.0;
+    const bool roof_columns = !options.roofline.empty();
+    const bool mem_stats_columns = options.mem_stats;
+    Roofline roof;
+    std::vector<RooflinePoint> roof_points;
+    if (roof_columns)
+    {
+        roof = measure_roofline(options, detected);
+        std::cout << "Roofline: banda " << roof.bandwidth_gbs << " GB/s, pico " << roof.peak_gops << " GOP/s ("
+                  << dtype_name(options.dtype) << ", " << isa_name(roof.peak_isa) << ", " << roof.threads
+                  << " thread(s)), cumeeira em " << (roof.peak_gops / roof.bandwidth_gbs) << " op/byte.\n";
+    }
+    file << "N,TCS,TAM,TDM" << (isa_column ? ",ISA" : "") << (mem_column ? ",MEM_EXTRA" : "")
+         << (convert_column ? ",T_CONVERSAO" : "") << (pack_column ? ",T_EMPACOTAMENTO" : "")
+         << (dtype_column ? ",DTYPE" : "") << (alloc_column ? ",ALLOC" : "") << (verify_column ? ",TVERIF" : "")
+         << (ooc_columns ? ",T_IO,T_COMPUTO,T_ESPERA,BYTES_IO,MEM_TRABALHO" : "")
+         << (stats_columns ? ",REPS,TCS_MEDIANA,TCS_MIN,TCS_DESVIO,TCS_P95,TCS_IC95_INF,TCS_IC95_SUP" : "")
+         << (roof_columns ? ",GOPS,INTENSIDADE,TETO_GOPS,FRACAO_TETO" : "")
+         << (mem_stats_columns ? ",RSS_PICO_TAM,RSS_PICO_TCS,RSS_PICO_TDM,FALTAS_MENORES_TAM,FALTAS_MAIORES_TAM,"
+                                 "FALTAS_MENORES_TCS,FALTAS_MAIORES_TCS,FALTAS_MENORES_TDM,FALTAS_MAIORES_TDM"
+                               : "")
+         << "\n";
+
+    for (int n : points)
+    {
+        PointResult result;
+        const Options point_options = apply_tuning(options, tuning, n);
+
+        if (!run_point(n, point_options, m_count, result))
+        {
+            return false;
+        }
+
+        file << n << "," << result.time_calc << "," << result.time_alloc << "," << result.time_free;
+        if (isa_column)
+        {
+            file << "," << isa_name(options.isa);
+        }
+        if (mem_column)
+        {
+            file << "," << result.extra_bytes;
+        }
+        if (convert_column)
+        {
+            file << "," << result.time_convert;
+        }
+        if (pack_column)
+        {
+            file << "," << mean_pack_time(result);
+        }
+        if (dtype_column)
+        {
+            file << "," << dtype_name(options.dtype);
+        }
+        if (alloc_column)
+        {
+            file << "," << alloc_name(options.alloc);
+        }
+        if (verify_column)
+        {
+            file << "," << result.time_verify;
+        }
+        if (ooc_columns)
+        {
+            file << "," << result.ooc.time_io << "," << result.ooc.time_compute << "," << result.ooc.time_wait
+                 << "," << result.ooc.io_bytes << "," << result.ooc.work_bytes;
+        }
+        if (stats_columns)
+        {
+            const SampleStats stats = calc_stats(result);
+            file << "," << result.samples.size() << "," << stats.median << "," << stats.min << "," << stats.stddev
+                 << "," << stats.p95 << "," << (stats.mean - stats.ci_half) << "," << (stats.mean + stats.ci_half);
+        }
+        if (roof_columns)
+        {
+            const RooflinePoint point = place_point(roof, n, result.time_calc, options.dtype);
+            file << "," << point.gops << "," << point.intensity << "," << point.roof_gops << ","
+                 << (point.gops / point.roof_gops);
+            roof_points.push_back(point);
+        }
+        if (mem_stats_columns)
+        {
+            for (int phase = 0; phase < kMemPhases; phase++)
+            {
+                file << "," << result.mem.rss_peak[phase];
+            }
+            for (int phase = 0; phase < kMemPhases; phase++)
+            {
+                file << "," << result.mem.minor_faults[phase] << "," << result.mem.major_faults[phase];
+            }
+        }
+        file << "\n";
+        write_sched_stats(stats_file, n, result);
+        write_perf_stats(perf_file, n, point_options.threads, result);
+        write_samples(samples_file, n, point_options.threads, result);
+
+        std::cout << "Resultados para N = " << n << " salvos.\n";
+    }
+
+    return !roof_columns || write_roofline_json(options.roofline, roof, options, roof_points);
+}
+
+} // namespace matbench::detail
+
+using namespace matbench::detail;
+
+// API da biblioteca (matbench.h). Cada chamada monta um Options como o da
+// linha de comando, sem afinidade, contadores ou arquivos de saída, e usa os
+// mesmos run_kernel e run_point; exceções viram -1 com a mensagem guardada
+// por thread para matbench_last_error.
+static thread_local std::string g_last_error;
+
+static int api_fail(const std::string &message)
+{
+    g_last_error = message;
+    return -1;
+}
+
+static Options api_options(const matbench_config *config, int n)
+{
+    if (config == nullptr)
+    {
+        throw std::invalid_argument("config nulo");
+    }
+    if (config->kernel < MATBENCH_NAIVE || config->kernel > MATBENCH_PACKED || config->dtype < MATBENCH_INT32 ||
+        config->dtype > MATBENCH_DOUBLE)
+    {
+        throw std::invalid_argument("kernel ou dtype invalido");
+    }
+    if (n < 1 || n > 100000 || config->threads < 0 || config->threads > 1024 || config->tile_i < 1 ||
+        config->tile_j < 1 || config->tile_k < 1 || config->strassen_cutoff < 1)
+    {
+        throw std::invalid_argument("N, threads, blocos ou corte do Strassen fora da faixa");
+    }
+
+    Options options;
+    options.kernel = static_cast<Kernel>(config->kernel);
+    options.dtype = static_cast<DType>(config->dtype);
+    options.threads = config->threads;
+    options.schedule = config->steal != 0 ? Schedule::Steal : Schedule::Static;
+    options.tile_i = config->tile_i;
+    options.tile_j = config->tile_j;
+    options.tile_k = config->tile_k;
+    options.strassen_cutoff = config->strassen_cutoff;
+    options.input = config->random_input != 0 ? Input::Random : Input::Identity;
+    options.verify = config->random_input != 0 ? Verify::Freivalds : Verify::Sample;
+    options.seed = config->seed;
+    options.isa = resolve_isa(Isa::Auto, detect_isa());
+    if (uses_isa(options.kernel) && options.dtype == DType::Int64)
+    {
+        options.isa = Isa::Scalar;
+    }
+    check_blas(options.kernel, options.dtype);
+    if (options.threads == 0)
+    {
+        options.threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    if (config->tune_cache != nullptr)
+    {
+        std::vector<TuneEntry> tuning;
+        const std::string cpu = cpu_model();
+        for (const TuneEntry &entry : load_tune_cache(config->tune_cache))
+        {
+            if (same_target(entry, cpu, options))
+            {
+                tuning.push_back(entry);
+            }
+        }
+        options = apply_tuning(options, tuning, n);
+    }
+    return options;
+}
+
+template <typename T>
+static void api_gemm(const void *a, const void *b, void *c, int n, const Options &options)
+{
+    T *res = static_cast<T *>(c);
+    std::fill(res, res + static_cast<size_t>(n) * n, T(0));
+    run_kernel(static_cast<const T *>(a), static_cast<const T *>(b), res, n, options, nullptr);
+}
+
+extern "C" void matbench_config_init(matbench_config *config)
+{
+    if (config == nullptr)
+    {
+        return;
+    }
+    const Options defaults;
+    config->kernel = MATBENCH_NAIVE;
+    config->dtype = MATBENCH_INT32;
+    config->threads = defaults.threads;
+    config->steal = 0;
+    config->tile_i = defaults.tile_i;
+    config->tile_j = defaults.tile_j;
+    config->tile_k = defaults.tile_k;
+    config->strassen_cutoff = defaults.strassen_cutoff;
+    config->random_input = 0;
+    config->seed = defaults.seed;
+    config->tune_cache = nullptr;
+}
+
+extern "C" int matbench_gemm(const matbench_config *config, int n, const void *a, const void *b, void *c)
+{
+    try
+    {
+        if (a == nullptr || b == nullptr || c == nullptr)
+        {
+            return api_fail("matriz nula");
+        }
+        const Options options = api_options(config, n);
+        switch (options.dtype)
+        {
+        case DType::Int64:
+            api_gemm<std::int64_t>(a, b, c, n, options);
+            break;
+        case DType::Float:
+            api_gemm<float>(a, b, c, n, options);
+            break;
+        case DType::Double:
+            api_gemm<double>(a, b, c, n, options);
+            break;
+        case DType::Int32:
+            api_gemm<std::int32_t>(a, b, c, n, options);
+            break;
+        }
+        return 0;
+    }
+    catch (const std::exception &ex)
+    {
+        return api_fail(ex.what());
+    }
+}
+
+template <typename T>
+static void api_gemm_ex(const matbench_gemm_args *args, const Options &options)
+{
+    if (!std::is_floating_point<T>::value &&
+        (!(std::fabs(args->alpha) <= static_cast<double>(std::numeric_limits<std::int32_t>::max())) ||
+         !(std::fabs(args->beta) <= static_cast<double>(std::numeric_limits<std::int32_t>::max()))))
+    {
+        throw std::invalid_argument("alpha e beta fora da faixa do dtype inteiro");
+    }
+    GemmArgs<T> g;
+    g.trans_a = args->trans_a != 0;
+    g.trans_b = args->trans_b != 0;
+    g.m = args->m;
+    g.n = args->n;
+    g.k = args->k;
+    g.alpha = static_cast<T>(args->alpha);
+    g.a = static_cast<const T *>(args->a);
+    g.lda = args->lda;
+    g.b = static_cast<const T *>(args->b);
+    g.ldb = args->ldb;
+    g.beta = static_cast<T>(args->beta);
+    g.c = static_cast<T *>(args->c);
+    g.ldc = args->ldc;
+    if (!std::is_floating_point<T>::value &&
+        (static_cast<double>(g.alpha) != args->alpha || static_cast<double>(g.beta) != args->beta))
+    {
+        throw std::invalid_argument("alpha e beta devem ser inteiros para dtype inteiro");
+    }
+    gemm(g, options);
+}
+
+extern "C" int matbench_gemm_ex(const matbench_config *config, const matbench_gemm_args *args)
+{
+    try
+    {
+        if (config == nullptr || args == nullptr)
+        {
+            return api_fail("config ou argumentos nulos");
+        }
+        // O GEMM geral tem kernel próprio: config->kernel não é conferido
+        // (MATBENCH_BLAS vale mesmo sem -DMATRIZ_BLAS).
+        matbench_config general = *config;
+        general.kernel = MATBENCH_NAIVE;
+        const Options options = api_options(&general, 1);
+        switch (options.dtype)
+        {
+        case DType::Int64:
+            api_gemm_ex<std::int64_t>(args, options);
+            break;
+        case DType::Float:
+            api_gemm_ex<float>(args, options);
+            break;
+        case DType::Double:
+            api_gemm_ex<double>(args, options);
+            break;
+        case DType::Int32:
+            api_gemm_ex<std::int32_t>(args, options);
+            break;
+        }
+        return 0;
+    }
+    catch (const std::exception &ex)
+    {
+        return api_fail(ex.what());
+    }
+}
+
+extern "C" int matbench_run(const matbench_config *config, int n, int reps, matbench_result *result)
+{
+    try
+    {
+        if (result == nullptr || reps < 1 || reps > kMaxRepetitions)
+        {
+            return api_fail("resultado nulo ou repeticoes fora da faixa");
+        }
+        const Options options = api_options(config, n);
+        PointResult point;
+        if (!run_point(n, options, reps, point))
+        {
+            return api_fail("Falha na verificacao ou na alocacao para N = " + std::to_string(n));
+        }
+        const SampleStats stats = calc_stats(point);
+        result->n = n;
+        result->reps = static_cast<int>(point.samples.size());
+        result->tcs = point.time_calc;
+        result->tam = point.time_alloc;
+        result->tdm = point.time_free;
+        result->tverif = point.time_verify;
+        result->t_convert = point.time_convert;
+        result->t_pack = mean_pack_time(point);
+        result->tcs_median = stats.median;
+        result->tcs_min = stats.min;
+        result->tcs_stddev = stats.stddev;
+        result->tcs_p95 = stats.p95;
+        result->tcs_ci95_low = stats.mean - stats.ci_half;
+        result->tcs_ci95_high = stats.mean + stats.ci_half;
+        result->gops = 2.0 * static_cast<double>(n) * n * n / point.time_calc / 1e9;
+        return 0;
+    }
+    catch (const std::exception &ex)
+    {
+        return api_fail(ex.what());
+    }
+}
+
+extern "C" int matbench_make_points(int b, int npts, int escala, int *points, int capacity)
+{
+    if (b < 100 || b > 100000 || npts < 2 || npts > 10000 || (escala != 0 && escala != 1))
+    {
+        return api_fail("Parametro invalido para B, Npts ou Escala");
+    }
+    if (points == nullptr || capacity < npts)
+    {
+        return api_fail("capacidade menor que Npts");
+    }
+    const std::vector<int> made = make_points(b, npts, escala);
+    std::copy(made.begin(), made.end(), points);
+    return npts;
+}
+
+extern "C" const char *matbench_isa(void)
+{
+    return isa_name(resolve_isa(Isa::Auto, detect_isa()));
+}
+
+extern "C" const char *matbench_last_error(void)
+{
+    return g_last_error.c_str();
+}
@@ -0,0 +1,224 @@
+/**********************************************************************
+ * Projeto: Benchmark de Multiplicação de Matrizes
+ * Descrição: API pública da libmatbench (C e C++). Expõe os mesmos
+ *            kernels e o mesmo medidor usados pelo executável
+ *            matriz_cpp, para que benchmarks dentro de outros programas
+ *            meçam exatamente o código dos números publicados.
+ *
+ * Linguagem: C / C++
+ *
+ * Uso:
+ *  - C: inclua matbench.h e ligue com libmatbench.a (ou .so) e
+ *    -lstdc++ -lpthread -lm; funções devolvem 0 em sucesso e -1 em erro,
+ *    com a mensagem em matbench_last_error().
+ *  - C++: o namespace matbench embrulha a API C e lança
+ *    std::runtime_error em erro.
+ *
+ * Matrizes são N x N, por linhas, contíguas. Os códigos de tipo são os
+ * mesmos do cabeçalho MATRIZB1. MATBENCH_API_VERSION muda a cada alteração
+ * incompatível das structs ou das assinaturas abaixo.
+ **********************************************************************/
+
+#ifndef MATBENCH_H
+#define MATBENCH_H
+
+#define MATBENCH_API_VERSION 4
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+typedef enum matbench_kernel
+{
+    MATBENCH_NAIVE = 0,
+    MATBENCH_BLOCKED = 1,
+    MATBENCH_SIMD = 2,
+    MATBENCH_STRASSEN = 3,
+    MATBENCH_BLAS = 4, /* só em libmatbench compilada com -DMATRIZ_BLAS; float/double */
+    MATBENCH_MORTON = 5,
+    MATBENCH_PACKED = 6 /* MC/KC/NC das caches; tile_* não são usados */
+} matbench_kernel;
+
+typedef enum matbench_dtype
+{
+    MATBENCH_INT32 = 0,
+    MATBENCH_INT64 = 1,
+    MATBENCH_FLOAT = 2,
+    MATBENCH_DOUBLE = 3
+} matbench_dtype;
+
+/* Configuração de um produto; matbench_config_init preenche os mesmos
+ * padrões da linha de comando. */
+typedef struct matbench_config
+{
+    matbench_kernel kernel;
+    matbench_dtype dtype;
+    int threads;         /* 0 = todas as CPUs lógicas */
+    int steal;           /* 0 = blocos de linhas fixos, 1 = roubo de tarefas */
+    int tile_i;
+    int tile_j;
+    int tile_k;
+    int strassen_cutoff;
+    int random_input;    /* matbench_run: 0 = identity (confere 9 elementos), 1 = random (Freivalds) */
+    unsigned long long seed;
+    const char *tune_cache; /* JSON do autotuner aplicado por N; NULL = não usa */
+} matbench_config;
+
+/* Resultado de matbench_run: médias por repetição em segundos e
+ * estatísticas do TCS, como nas colunas do CSV. */
+typedef struct matbench_result
+{
+    int n;
+    int reps;
+    double tcs;
+    double tam;
+    double tdm;
+    double tverif;
+    double t_convert; /* morton: conversões de layout, fora de tcs (0 nos outros kernels) */
+    double t_pack;    /* packed: empacotamento de painéis, dentro de tcs (0 nos outros kernels) */
+    double tcs_median;
+    double tcs_min;
+    double tcs_stddev;
+    double tcs_p95;
+    double tcs_ci95_low;
+    double tcs_ci95_high;
+    double gops;
+} matbench_result;
+
+void matbench_config_init(matbench_config *config); /* config NULL: não faz nada */
+
+/* c = a x b com o kernel de config (c é sobrescrita). */
+int matbench_gemm(const matbench_config *config, int n, const void *a, const void *b, void *c);
+
+/* C = alpha op(A) op(B) + beta C, por linhas: C é m x n, op(A) m x k e
+ * op(B) k x n; op(X) = X^T quando trans_x != 0. lda/ldb/ldc são os passos
+ * entre linhas (>= largura armazenada), para operar em submatrizes. Com
+ * beta = 0, C não é lida. Para dtypes inteiros, alpha e beta devem ser
+ * inteiros. */
+typedef struct matbench_gemm_args
+{
+    int trans_a;
+    int trans_b;
+    int m;
+    int n;
+    int k;
+    double alpha;
+    const void *a;
+    int lda;
+    const void *b;
+    int ldb;
+    double beta;
+    void *c;
+    int ldc;
+} matbench_gemm_args;
+
+/* GEMM geral com config->dtype, threads e blocos (config->kernel é ignorado). */
+int matbench_gemm_ex(const matbench_config *config, const matbench_gemm_args *args);
+
+/* Uma repetição de aquecimento e reps medidas de alocação, preenchimento,
+ * produto, verificação e liberação, como cada N do CSV padrão. */
+int matbench_run(const matbench_config *config, int n, int reps, matbench_result *result);
+
+/* Pontos N de 100 até b (escala 1 = linear, 0 = logarítmica); grava até
+ * capacity valores e devolve npts, ou -1 em erro. */
+int matbench_make_points(int b, int npts, int escala, int *points, int capacity);
+
+/* ISA que o kernel simd usa nesta CPU ("scalar", "sse4.1", "avx2" ou "avx512"). */
+const char *matbench_isa(void);
+
+/* Mensagem do último erro da thread chamadora ("" se nenhum); válida até a
+ * próxima falha na mesma thread. */
+const char *matbench_last_error(void);
+
+#ifdef __cplusplus
+}
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace matbench
+{
+using Config = matbench_config;
+using Result = matbench_result;
+
+template <typename T>
+struct DTypeOf;
+template <>
+struct DTypeOf<std::int32_t>
+{
+    static const matbench_dtype value = MATBENCH_INT32;
+};
+template <>
+struct DTypeOf<std::int64_t>
+{
+    static const matbench_dtype value = MATBENCH_INT64;
+};
+template <>
+struct DTypeOf<float>
+{
+    static const matbench_dtype value = MATBENCH_FLOAT;
+};
+template <>
+struct DTypeOf<double>
+{
+    static const matbench_dtype value = MATBENCH_DOUBLE;
+};
+
+inline Config default_config(matbench_kernel kernel = MATBENCH_NAIVE, matbench_dtype dtype = MATBENCH_INT32)
+{
+    Config config;
+    matbench_config_init(&config);
+    config.kernel = kernel;
+    config.dtype = dtype;
+    return config;
+}
+
+inline void check(int status)
+{
+    if (status != 0)
+    {
+        throw std::runtime_error(matbench_last_error());
+    }
+}
+
+// O dtype vem do tipo dos ponteiros; o de config é ignorado.
+template <typename T>
+inline void gemm(const T *a, const T *b, T *c, int n, Config config = default_config())
+{
+    config.dtype = DTypeOf<T>::value;
+    check(matbench_gemm(&config, n, a, b, c));
+}
+
+// C = alpha op(A) op(B) + beta C com os passos lda/ldb/ldc (veja matbench_gemm_args).
+template <typename T>
+inline void gemm(bool trans_a, bool trans_b, int m, int n, int k, T alpha, const T *a, int lda, const T *b, int ldb,
+                 T beta, T *c, int ldc, Config config = default_config())
+{
+    config.dtype = DTypeOf<T>::value;
+    const matbench_gemm_args args = {trans_a ? 1 : 0, trans_b ? 1 : 0, m, n, k, static_cast<double>(alpha), a, lda,
+                                     b, ldb, static_cast<double>(beta), c, ldc};
+    check(matbench_gemm_ex(&config, &args));
+}
+
+inline Result run(int n, int reps, const Config &config = default_config())
+{
+    Result result;
+    check(matbench_run(&config, n, reps, &result));
+    return result;
+}
+
+inline std::vector<int> make_points(int b, int npts, int escala)
+{
+    std::vector<int> points(npts > 0 ? static_cast<size_t>(npts) : 0);
+    if (matbench_make_points(b, npts, escala, points.data(), npts) < 0)
+    {
+        throw std::runtime_error(matbench_last_error());
+    }
+    return points;
+}
+} // namespace matbench
+#endif
+
+#endif
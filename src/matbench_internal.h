@@ -0,0 +1,283 @@
+/**********************************************************************
+ * Projeto: Benchmark de Multiplicação de Matrizes
+ * Descrição: Interface interna entre o núcleo da libmatbench
+ *            (matbench.cpp) e a linha de comando do matriz_cpp
+ *            (matriz_cpp.cpp): as opções já lidas, os tipos que elas
+ *            usam e os modos de execução que a linha de comando despacha.
+ *            Não faz parte da API pública (matbench.h) e muda sem
+ *            alterar MATBENCH_API_VERSION; os dois arquivos devem ser
+ *            compilados com as mesmas definições (-DMATRIZ_BLAS).
+ *
+ * Linguagem: C++
+ *
+ * Autores: Lucas Kriesel Sperotto, Marcos Adriano Silva David
+ * Data: 05/09/2024
+ **********************************************************************/
+
+#ifndef MATBENCH_INTERNAL_H
+#define MATBENCH_INTERNAL_H
+
+#include <cstdint>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIZ_X86_SIMD 1
+#endif
+
+#if defined(__linux__)
+#define MATRIZ_MADVISE 1
+#define MATRIZ_PERF 1
+#define MATRIZ_MMAP 1
+#define MATRIZ_AFFINITY 1
+#define MATRIZ_RUSAGE 1
+#endif
+
+namespace matbench::detail
+{
+enum class Kernel
+{
+    Naive,
+    Blocked,
+    Simd,
+    Strassen,
+    Blas,
+    Morton,
+    Packed
+};
+
+// Ordem crescente de capacidade; Auto só existe na linha de comando.
+enum class Isa
+{
+    Auto,
+    Scalar,
+    Sse41,
+    Avx2,
+    Avx512
+};
+
+enum class DType
+{
+    Int32,
+    Int64,
+    Float,
+    Double
+};
+
+enum class AllocPolicy
+{
+    Vector,
+    Arena,
+    HugePage
+};
+
+enum class Schedule
+{
+    Static,
+    Steal
+};
+
+enum class Input
+{
+    Identity,
+    Random
+};
+
+enum class Verify
+{
+    Sample,
+    Freivalds
+};
+
+enum class InitMode
+{
+    Serial,
+    Parallel
+};
+
+enum class Pin
+{
+    None,
+    Compact,
+    Scatter,
+    List
+};
+
+enum class DistAlgorithm
+{
+    Summa,
+    Cannon
+};
+
+// Formas do modo --gemm para o ponto n, com s = n / --shape-ratio:
+// square M = N = K = n; tall M = n, N = K = s (alta e estreita); wide
+// N = n, M = K = s (baixa e larga); inner K = n, M = N = s (produto
+// interno); outer M = N = n, K = s (atualização de posto K).
+enum class Shape
+{
+    Square,
+    Tall,
+    Wide,
+    Inner,
+    Outer
+};
+
+// op(A) op(B) do GEMM geral: n = operando como está, t = transposto.
+enum class GemmTrans
+{
+    NN,
+    NT,
+    TN,
+    TT
+};
+
+struct Options
+{
+    Kernel kernel = Kernel::Naive;
+    DType dtype = DType::Int32;
+    AllocPolicy alloc = AllocPolicy::Vector;
+    Isa isa = Isa::Auto;
+    Input input = Input::Identity;
+    Verify verify = Verify::Sample;
+    std::uint64_t seed = 42;
+    std::string meta_json;
+    int tile_i = 64;
+    int tile_j = 256;
+    int tile_k = 128;
+    int strassen_cutoff = 128;
+    int threads = 1;
+    Schedule schedule = Schedule::Static;
+    InitMode init = InitMode::Serial;
+    Pin pin = Pin::None;
+    // CPU de cada thread (a thread t usa pin_cpus[t % tamanho]); vazio = sem afinidade.
+    std::vector<int> pin_cpus;
+    std::string sched_stats;
+    std::string perf_stats;
+    bool mem_stats = false;
+    std::string samples;
+    std::string roofline;
+    double ci_target = 0.0;
+    double time_cap = 60.0;
+    bool threads_sweep = false;
+    int max_threads = 0;
+    int batch = 0;
+    std::vector<double> sparse;
+    std::vector<Kernel> sweep_kernels;
+    std::vector<DType> sweep_dtypes;
+    std::string results_json;
+    std::string ooc_dir;
+    int ooc_mem = 256;
+    int distributed = 0;
+    DistAlgorithm dist_algorithm = DistAlgorithm::Summa;
+    std::vector<Shape> gemm_shapes;
+    std::vector<GemmTrans> gemm_trans;
+    double alpha = 1.0;
+    double beta = 0.0;
+    int ld_pad = 0;
+    int shape_ratio = 16;
+    std::string mat1;
+    std::string mat2;
+    std::string res_out;
+    bool tune = false;
+    std::string tune_cache = "build/matriz_cpp_tune.json";
+    // Opções passadas explicitamente; o cache do autotuner não as sobrescreve.
+    std::set<std::string> given;
+};
+
+// Formato binário de matriz (--mat1, --mat2, --res-out), little-endian:
+// cabeçalho de 64 bytes e a carga útil em `rows` linhas de `stride`
+// elementos a partir do byte `offset`, múltiplo de `alignment` (4096 ao
+// gravar, para a carga ficar alinhada à página e ser usada direto do mmap).
+// dtype: 0 = int32, 1 = int64, 2 = float, 3 = double.
+//   bytes  0..7   magic "MATRIZB1"    bytes 32..39  stride (elementos)
+//   bytes  8..11  dtype               bytes 40..47  alignment (bytes)
+//   bytes 12..15  tamanho do elemento bytes 48..55  offset (bytes)
+//   bytes 16..31  rows, cols          bytes 56..63  reservado (zero)
+struct MatrixFileHeader
+{
+    char magic[8];
+    std::uint32_t dtype;
+    std::uint32_t elem_size;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t stride;
+    std::uint64_t alignment;
+    std::uint64_t offset;
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(MatrixFileHeader) == 64, "cabecalho do formato binario deve ter 64 bytes");
+
+// Faixa de N do cache do autotuner (--tune) com os parâmetros escolhidos.
+struct TuneEntry
+{
+    std::string cpu;
+    std::string kernel;
+    std::string dtype;
+    int n = 0;
+    int n_min = 0;
+    int n_max = 0;
+    int tile_i = 0;
+    int tile_j = 0;
+    int tile_k = 0;
+    int threads = 1;
+    Schedule schedule = Schedule::Static;
+    int strassen_cutoff = 0;
+    double time_calc = 0.0;
+};
+
+// Leitura de números e listas de CPUs (linha de comando e /sys), nomes das
+// opções e ISA da CPU.
+int parse_int(const char *text, const std::string &name, int min_value, int max_value);
+std::vector<int> parse_cpu_list(const std::string &text, const std::string &name);
+const char *kernel_name(Kernel kernel);
+bool uses_isa(Kernel kernel);
+void check_blas(Kernel kernel, DType dtype);
+const char *dtype_name(DType dtype);
+const char *pin_name(Pin pin);
+const char *isa_name(Isa isa);
+Isa detect_isa();
+Isa resolve_isa(Isa requested, Isa detected);
+std::string json_int_list(const std::vector<int> &values);
+#ifdef MATRIZ_BLAS
+std::string blas_library();
+#endif
+
+// Preparação da execução: pontos N, afinidade, arquivos de entrada, cache
+// do autotuner, --meta-json e contadores de --perf-stats.
+std::vector<int> make_points(int b, int npts, int escala);
+void print_packed_blocking(const Options &options);
+std::vector<int> pin_layout(const Options &options);
+void pin_thread(const Options &options, int thread);
+MatrixFileHeader read_matrix_header(const std::string &path);
+std::string cpu_model();
+bool same_target(const TuneEntry &entry, const std::string &cpu, const Options &options);
+std::vector<TuneEntry> load_tune_cache(const std::string &path);
+bool has_tune_axes(const Options &options, int n);
+bool write_meta_json(const Options &options, Isa detected, const std::string &cpu,
+                     const std::vector<TuneEntry> &tuning);
+void open_perf_counters();
+
+// Modos de execução: cada um grava o próprio CSV em file; false significa
+// erro (verificação, tamanho ou arquivo) já informado em std::cerr.
+bool run_tune(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file,
+              const std::string &cpu, std::vector<TuneEntry> &tuning);
+bool run_threads_sweep(const std::vector<int> &points, const Options &options,
+                       const std::vector<TuneEntry> &tuning, int m_count, std::ofstream &file,
+                       std::ofstream *stats_file, std::ofstream *perf_file, std::ofstream *samples_file);
+bool run_sweep(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file,
+               const std::string &cpu);
+bool run_batch(const Options &options, int m_count, std::ofstream &file);
+bool run_gemm(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file);
+bool run_sparse(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file);
+#ifdef MATRIZ_MMAP
+bool run_distributed(const std::vector<int> &points, const Options &options, int m_count, std::ofstream &file);
+#endif
+bool run_standard(const std::vector<int> &points, const Options &options,
+                  const std::vector<TuneEntry> &tuning, int m_count, Isa detected, std::ofstream &file,
+                  std::ofstream *stats_file, std::ofstream *perf_file, std::ofstream *samples_file);
+} // namespace matbench::detail
+
+#endif
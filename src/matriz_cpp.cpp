@@ -1,184 +1,679 @@
 /**********************************************************************
  * Projeto: Benchmark de Multiplicação de Matrizes
- * Descrição: Este código realiza a multiplicação de duas matrizes
- *            de tamanho N x N, variando automaticamente o valor de N
- *            e medindo o tempo de alocação de memória, cálculo,
- *            e liberação de memória.
- *            O código salva os resultados em um arquivo de saída.
+ * Descrição: Executável matriz_cpp: interface de linha de comando da
+ *            libmatbench. Lê os argumentos e as opções, confere as
+ *            combinações e despacha o modo de execução; kernels, medição
+ *            e os modos ficam na biblioteca (matbench.cpp), chamados por
+ *            matbench_internal.h.
  *
  * Linguagem: C++
  *
  * Autores: Lucas Kriesel Sperotto, Marcos Adriano Silva David
  * Data: 05/09/2024
  *
- * Parâmetros:
- *  - N: tamanho da matriz (varia de 100 até B)
- *
- * Saída: Arquivo de resultados contendo:
- *  - Tempo de alocação de memória
- *  - Tempo de cálculo (multiplicação das matrizes)
- *  - Tempo de liberação de memória
- *
  * Uso:
- *  - Compile e execute o código, e o arquivo de saída será gerado
- *    contendo os resultados para diferentes valores de N.
+ *  - matriz_cpp <B> <Npts> <M> <Escala> <out_csv> [opcoes]
+ *
+ * Opções (após os argumentos posicionais):
+ *  - --kernel naive|blocked: algoritmo de multiplicação (padrão naive)
+ *  - --kernel simd: micro-kernels int32 SSE4.1/AVX2/AVX-512 escolhidos
+ *    em tempo de execução via cpuid
+ *  - --kernel packed: estilo GotoBLAS, A e B copiados em micro-painéis
+ *    com blocos MC/KC/NC tirados dos tamanhos de L1/L2/L3 e micro-kernel
+ *    6 x NR em registradores (mesmos ISAs do simd); o empacotamento faz
+ *    parte do TCS e sai também na coluna T_EMPACOTAMENTO; com threads, B é
+ *    empacotado uma vez por painel e só os blocos de A são divididos
+ *  - --isa auto|scalar|sse4.1|avx2|avx512: força o ISA dos kernels simd e
+ *    packed
+ *  - --kernel blas: ?gemm de uma CBLAS (OpenBLAS ou BLIS) com --threads
+ *    threads da biblioteca, só float/double e só se compilado com
+ *    -DMATRIZ_BLAS (run_all.sh detecta a biblioteca)
+ *  - --kernel morton: matrizes convertidas para o layout Morton (ordem Z
+ *    de blocos) e produto recursivo cache-oblivious, sem blocos ajustados
+ *    por máquina; conversões fora do TCS, na coluna T_CONVERSAO
+ *  - --kernel strassen: Strassen recursivo com preenchimento (padding) até
+ *    um múltiplo de 2^L e caso base em blocos abaixo de --strassen-cutoff
+ *  - --dtype int32|int64|float|double: tipo dos elementos (padrão int32)
+ *  - --alloc vector|arena|hugepage: vetores novos a cada repetição (padrão),
+ *    arena de blocos alinhados reaproveitados ou blocos de 2 MB com THP
+ *  - --input identity|random: mat1[i][j] = i + j e mat2 identidade (padrão)
+ *    ou valores aleatórios a partir de --seed (padrão 42)
+ *  - --verify sample|freivalds: confere 9 elementos de res (só identity) ou
+ *    res inteiro com o teste de Freivalds em O(N^2), fora do TCS e gravado
+ *    na coluna TVERIF (padrão com --input random)
+ *  - --tile-i/--tile-j/--tile-k: tamanhos de bloco dos kernels blocked/simd
+ *    (no packed, substituem MC, NC e KC quando passados)
+ *  - --threads <T>: divide as linhas de res em T blocos, um por thread
+ *    (0 = todas as CPUs lógicas)
+ *  - --schedule static|steal: blocos de linhas fixos ou blocos 2-D de res
+ *    (tile_i x tile_j) em filas por thread com roubo de tarefas
+ *  - --init serial|parallel: entradas preenchidas pela thread principal
+ *    (padrão) ou primeiro toque paralelo, cada thread inicializando os
+ *    blocos que calcula, para as páginas ficarem no seu nó NUMA
+ *  - --pin none|compact|scatter|<lista>: prende as threads a CPUs
+ *    (sched_setaffinity, só Linux) agrupadas por núcleo e nó NUMA,
+ *    espalhadas entre nós ou na lista dada (ex.: 0,2,4-7); o layout vai
+ *    para o --meta-json
+ *  - --sched-stats <csv>: tempo ocupado/ocioso, tarefas e roubos por thread
+ *  - --perf-stats <csv>: ciclos, instruções, IPC e falhas de L1D, LLC e
+ *    dTLB do kernel (perf_event_open, só Linux), médias por N
+ *  - --mem-stats: o CSV principal ganha pico de RSS e faltas de página
+ *    menores/maiores de cada fase (alocação, cálculo e liberação), por
+ *    getrusage e /proc/self (só Linux)
+ *  - --samples <csv>: tempos de cada repetição; o CSV principal ganha
+ *    REPS, mediana, mínimo, desvio padrão, p95 e IC de 95% do TCS
+ *  - --ci-target <fração>: repete além de M até a meia largura do IC de
+ *    95% do TCS ficar abaixo dessa fração da média, ou até --time-cap
+ *    segundos por ponto (padrão 60)
+ *  - --roofline <json>: mede banda de memória (tríade STREAM) e pico de
+ *    computação na inicialização e grava GOP/s, intensidade aritmética e a
+ *    fração do teto do roofline para cada N
+ *  - --threads-sweep: para cada N, mede T = 1, 2, 4, ... até --max-threads
+ *    e grava N,THREADS,TCS,SPEEDUP,EFICIENCIA no lugar do CSV padrão
+ *  - --sweep <k1,k2,...>: roda os kernels listados (e cada tipo de
+ *    --sweep-dtypes) intercalados no mesmo processo, uma repetição de cada
+ *    por rodada, e grava kernel, dtype, threads, N e estatísticas do TCS
+ *    em um único CSV no lugar do padrão (e em --results-json, com amostras)
+ *  - --gemm <f1,f2,...>: GEMM geral C = alpha op(A) op(B) + beta C com
+ *    formas retangulares (square, tall, wide, inner, outer; lado menor
+ *    N / --shape-ratio, padrão 16), transposições --trans nn,nt,tn,tt,
+ *    --alpha/--beta (padrão 1 e 0; inteiros em [-100, 100] nos dtypes
+ *    inteiros) e --ld-pad elementos de folga por linha,
+ *    gravando M, N, K, tempos e GOP/s por forma no lugar do CSV padrão
+ *  - --batch <quantidade>: multiplica lotes de matrizes 4x4 a 32x32 com
+ *    kernels especializados em tempo de compilação e com o kernel genérico,
+ *    gravando matrizes/s e GFLOP/s de cada um no lugar do CSV padrão
+ *  - --sparse <d1,d2,...>: para cada N e densidade, converte mat1 para CSR e
+ *    mede SpMM (CSR x densa) e SpGEMM (CSR x CSR) contra o kernel denso,
+ *    todos com --threads threads, gravando ganhos, custo de conversão e
+ *    memória no lugar do CSV padrão
+ *  - --mat1/--mat2 <arquivo>: lê as matrizes de arquivos no formato binário
+ *    MATRIZB1 (mmap, sem cópia), mede um único N com TAM = tempo de carga
+ *    e confere com Freivalds; --res-out <arquivo> grava res no mesmo formato
+ *  - --ooc <dir>: multiplica fora do núcleo, com as matrizes em arquivos
+ *    mapeados em <dir> e blocos limitados a --ooc-mem MiB (padrão 256),
+ *    gravando E/S e cálculo em colunas separadas
+ *  - --distributed <P>: P = q x q processos (fork) em grade 2-D trocando
+ *    blocos por memória compartilhada com --dist-algorithm summa|cannon
+ *    (padrão summa), gravando por processo tempo de cálculo, comunicação,
+ *    sincronização e bytes movidos no lugar do CSV padrão (só Linux)
+ *  - --tune: busca, para cada N, blocos, threads e corte do Strassen de
+ *    menor TCS e grava no cache --tune-cache (padrão
+ *    build/matriz_cpp_tune.json) por modelo de CPU, kernel e dtype;
+ *    execuções normais aplicam o cache (--no-tune-cache desliga)
+ *  - --meta-json <arquivo>: grava a configuração efetiva da execução
  **********************************************************************/
 
+#include "matbench_internal.h"
 
-#include <chrono>
+#include <algorithm>
 #include <cmath>
-#include <cstdlib>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <limits>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
-using Clock = std::chrono::steady_clock;
+using namespace matbench::detail;
 
-static double elapsed_seconds(Clock::time_point start, Clock::time_point end)
+static double parse_double(const char *text, const std::string &name, double min_value, double max_value)
 {
-    return std::chrono::duration<double>(end - start).count();
+    std::string value_text(text);
+    size_t consumed = 0;
+    double value = 0.0;
+
+    try
+    {
+        value = std::stod(value_text, &consumed);
+    }
+    catch (const std::exception &)
+    {
+        throw std::invalid_argument("Parametro invalido para " + name + ": " + value_text);
+    }
+
+    if (consumed != value_text.size() || !(value >= min_value && value <= max_value))
+    {
+        throw std::invalid_argument("Parametro invalido para " + name + ": " + value_text);
+    }
+
+    return value;
 }
 
-static int parse_int(const char *text, const std::string &name, int min_value, int max_value)
+static std::uint64_t parse_seed(const char *text, const std::string &name)
 {
     std::string value_text(text);
     size_t consumed = 0;
-    long value = 0;
+    unsigned long long value = 0;
 
     try
     {
-        value = std::stol(value_text, &consumed, 10);
+        value = std::stoull(value_text, &consumed, 10);
     }
     catch (const std::exception &)
     {
         throw std::invalid_argument("Parametro invalido para " + name + ": " + value_text);
     }
 
-    if (consumed != value_text.size() || value < min_value || value > max_value)
+    if (consumed != value_text.size() || value_text[0] == '-')
     {
         throw std::invalid_argument("Parametro invalido para " + name + ": " + value_text);
     }
 
-    return static_cast<int>(value);
+    return static_cast<std::uint64_t>(value);
 }
 
-static std::vector<int> make_points(int b, int npts, int escala)
+// Lista de densidades separadas por vírgula, cada uma em (0, 1].
+static std::vector<double> parse_densities(const std::string &text, const std::string &name)
 {
-    const double a = 100.0;
-    std::vector<int> points;
-    points.reserve(static_cast<size_t>(npts));
-
-    if (escala == 1)
+    std::vector<double> values;
+    size_t begin = 0;
+    while (begin <= text.size())
     {
-        const double step = (static_cast<double>(b) - a) / static_cast<double>(npts - 1);
-        for (int i = 0; i < npts; i++)
+        const size_t end = std::min(text.find(',', begin), text.size());
+        const std::string item = text.substr(begin, end - begin);
+        const double value = parse_double(item.c_str(), name, 0.0, 1.0);
+        if (value <= 0.0)
         {
-            points.push_back(static_cast<int>(std::round(a + step * i)));
+            throw std::invalid_argument("Parametro invalido para " + name + ": " + item);
         }
+        values.push_back(value);
+        begin = end + 1;
     }
-    else
+    return values;
+}
+
+static Kernel parse_kernel(const std::string &text)
+{
+    if (text == "naive")
     {
-        const double ratio = std::pow(static_cast<double>(b) / a, 1.0 / static_cast<double>(npts - 1));
-        for (int i = 0; i < npts; i++)
-        {
-            points.push_back(static_cast<int>(std::round(a * std::pow(ratio, i))));
-        }
+        return Kernel::Naive;
     }
+    if (text == "blocked")
+    {
+        return Kernel::Blocked;
+    }
+    if (text == "simd")
+    {
+        return Kernel::Simd;
+    }
+    if (text == "strassen")
+    {
+        return Kernel::Strassen;
+    }
+    if (text == "blas")
+    {
+        return Kernel::Blas;
+    }
+    if (text == "morton")
+    {
+        return Kernel::Morton;
+    }
+    if (text == "packed")
+    {
+        return Kernel::Packed;
+    }
+    throw std::invalid_argument("Kernel desconhecido: " + text +
+                                " (use naive, blocked, simd, strassen, blas, morton ou packed)");
+}
 
-    return points;
+static DType parse_dtype(const std::string &text)
+{
+    if (text == "int32")
+    {
+        return DType::Int32;
+    }
+    if (text == "int64")
+    {
+        return DType::Int64;
+    }
+    if (text == "float")
+    {
+        return DType::Float;
+    }
+    if (text == "double")
+    {
+        return DType::Double;
+    }
+    throw std::invalid_argument("Tipo desconhecido: " + text + " (use int32, int64, float ou double)");
 }
 
-static void multiply(const std::vector<int> &mat1, const std::vector<int> &mat2, std::vector<int> &res, int n)
+// Itens separados por vírgula, cada um convertido por parse (sem repetidos).
+template <typename T>
+static std::vector<T> parse_list(const std::string &text, const std::string &name, T (*parse)(const std::string &))
 {
-    for (int i = 0; i < n; i++)
+    std::vector<T> values;
+    size_t begin = 0;
+    while (begin <= text.size())
     {
-        for (int j = 0; j < n; j++)
+        const size_t end = std::min(text.find(',', begin), text.size());
+        const T value = parse(text.substr(begin, end - begin));
+        if (std::find(values.begin(), values.end(), value) != values.end())
         {
-            int sum = 0;
-            for (int k = 0; k < n; k++)
-            {
-                sum += mat1[static_cast<size_t>(i) * n + k] * mat2[static_cast<size_t>(k) * n + j];
-            }
-            res[static_cast<size_t>(i) * n + j] = sum;
+            throw std::invalid_argument("Item repetido em " + name + ": " + text.substr(begin, end - begin));
         }
+        values.push_back(value);
+        begin = end + 1;
     }
+    return values;
 }
 
-static bool verify_sample(const std::vector<int> &res, int n)
+static AllocPolicy parse_alloc(const std::string &text)
 {
-    const int idxs[3] = {0, n / 2, n - 1};
+    if (text == "vector")
+    {
+        return AllocPolicy::Vector;
+    }
+    if (text == "arena")
+    {
+        return AllocPolicy::Arena;
+    }
+    if (text == "hugepage")
+    {
+        return AllocPolicy::HugePage;
+    }
+    throw std::invalid_argument("Politica de alocacao desconhecida: " + text + " (use vector, arena ou hugepage)");
+}
 
-    for (int i : idxs)
+static Input parse_input(const std::string &text)
+{
+    if (text == "identity")
     {
-        for (int j : idxs)
-        {
-            if (res[static_cast<size_t>(i) * n + j] != i + j)
-            {
-                std::cerr << "Erro na multiplicacao para N=" << n << " em [" << i << "," << j << "]\n";
-                return false;
-            }
-        }
+        return Input::Identity;
+    }
+    if (text == "random")
+    {
+        return Input::Random;
     }
+    throw std::invalid_argument("Entrada desconhecida: " + text + " (use identity ou random)");
+}
 
-    return true;
+static Verify parse_verify(const std::string &text)
+{
+    if (text == "sample")
+    {
+        return Verify::Sample;
+    }
+    if (text == "freivalds")
+    {
+        return Verify::Freivalds;
+    }
+    throw std::invalid_argument("Verificacao desconhecida: " + text + " (use sample ou freivalds)");
 }
 
-static bool run_once(int n, double &time_alloc, double &time_calc, double &time_free)
+static InitMode parse_init(const std::string &text)
 {
-    const size_t n_size = static_cast<size_t>(n);
-    if (n_size > std::numeric_limits<size_t>::max() / n_size)
+    if (text == "serial")
+    {
+        return InitMode::Serial;
+    }
+    if (text == "parallel")
     {
-        std::cerr << "N muito grande: " << n << "\n";
-        return false;
+        return InitMode::Parallel;
     }
-    const size_t n2 = n_size * n_size;
+    throw std::invalid_argument("Inicializacao desconhecida: " + text + " (use serial ou parallel)");
+}
 
-    auto start = Clock::now();
-    std::vector<int> mat1(n2);
-    std::vector<int> mat2(n2);
-    std::vector<int> res(n2);
+// none, compact, scatter ou uma lista explícita de CPUs.
+static Pin parse_pin(const std::string &text, std::vector<int> &cpus)
+{
+    cpus.clear();
+    if (text == "none")
+    {
+        return Pin::None;
+    }
+    if (text == "compact")
+    {
+        return Pin::Compact;
+    }
+    if (text == "scatter")
+    {
+        return Pin::Scatter;
+    }
+    if (text.empty() || text.find_first_not_of("0123456789,-") != std::string::npos)
+    {
+        throw std::invalid_argument("Afinidade desconhecida: " + text + " (use none, compact, scatter ou lista "
+                                    "de CPUs como 0,2,4-7)");
+    }
+    cpus = parse_cpu_list(text, "--pin");
+    return Pin::List;
+}
 
-    for (int i = 0; i < n; i++)
+static DistAlgorithm parse_dist_algorithm(const std::string &text)
+{
+    if (text == "summa")
     {
-        for (int j = 0; j < n; j++)
-        {
-            mat1[static_cast<size_t>(i) * n + j] = i + j;
-            mat2[static_cast<size_t>(i) * n + j] = (i == j) ? 1 : 0;
-        }
+        return DistAlgorithm::Summa;
+    }
+    if (text == "cannon")
+    {
+        return DistAlgorithm::Cannon;
     }
-    auto end = Clock::now();
-    time_alloc += elapsed_seconds(start, end);
+    throw std::invalid_argument("Algoritmo distribuido desconhecido: " + text + " (use summa ou cannon)");
+}
 
-    start = Clock::now();
-    multiply(mat1, mat2, res, n);
-    end = Clock::now();
-    time_calc += elapsed_seconds(start, end);
+static Shape parse_shape(const std::string &text)
+{
+    if (text == "square")
+    {
+        return Shape::Square;
+    }
+    if (text == "tall")
+    {
+        return Shape::Tall;
+    }
+    if (text == "wide")
+    {
+        return Shape::Wide;
+    }
+    if (text == "inner")
+    {
+        return Shape::Inner;
+    }
+    if (text == "outer")
+    {
+        return Shape::Outer;
+    }
+    throw std::invalid_argument("Forma desconhecida: " + text + " (use square, tall, wide, inner ou outer)");
+}
 
-    if (!verify_sample(res, n))
+static GemmTrans parse_gemm_trans(const std::string &text)
+{
+    if (text == "nn")
+    {
+        return GemmTrans::NN;
+    }
+    if (text == "nt")
+    {
+        return GemmTrans::NT;
+    }
+    if (text == "tn")
+    {
+        return GemmTrans::TN;
+    }
+    if (text == "tt")
     {
-        return false;
+        return GemmTrans::TT;
     }
+    throw std::invalid_argument("Transposicao desconhecida: " + text + " (use nn, nt, tn ou tt)");
+}
 
-    start = Clock::now();
-    std::vector<int>().swap(mat1);
-    std::vector<int>().swap(mat2);
-    std::vector<int>().swap(res);
-    end = Clock::now();
-    time_free += elapsed_seconds(start, end);
+static Schedule parse_schedule(const std::string &text)
+{
+    if (text == "static")
+    {
+        return Schedule::Static;
+    }
+    if (text == "steal")
+    {
+        return Schedule::Steal;
+    }
+    throw std::invalid_argument("Escalonamento desconhecido: " + text + " (use static ou steal)");
+}
 
-    return true;
+static Isa parse_isa(const std::string &text)
+{
+    if (text == "auto")
+    {
+        return Isa::Auto;
+    }
+    if (text == "scalar")
+    {
+        return Isa::Scalar;
+    }
+    if (text == "sse4.1")
+    {
+        return Isa::Sse41;
+    }
+    if (text == "avx2")
+    {
+        return Isa::Avx2;
+    }
+    if (text == "avx512")
+    {
+        return Isa::Avx512;
+    }
+    throw std::invalid_argument("ISA desconhecido: " + text + " (use auto, scalar, sse4.1, avx2 ou avx512)");
+}
+
+static Options parse_options(int argc, char **argv, int first)
+{
+    Options options;
+
+    for (int i = first; i < argc; i++)
+    {
+        const std::string name(argv[i]);
+        options.given.insert(name);
+        if (name == "--threads-sweep")
+        {
+            options.threads_sweep = true;
+            continue;
+        }
+        if (name == "--tune")
+        {
+            options.tune = true;
+            continue;
+        }
+        if (name == "--mem-stats")
+        {
+            options.mem_stats = true;
+            continue;
+        }
+        if (name == "--no-tune-cache")
+        {
+            options.tune_cache.clear();
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Valor ausente para " + name);
+        }
+        const char *value = argv[++i];
+
+        if (name == "--kernel")
+        {
+            options.kernel = parse_kernel(value);
+        }
+        else if (name == "--dtype")
+        {
+            options.dtype = parse_dtype(value);
+        }
+        else if (name == "--alloc")
+        {
+            options.alloc = parse_alloc(value);
+        }
+        else if (name == "--isa")
+        {
+            options.isa = parse_isa(value);
+        }
+        else if (name == "--input")
+        {
+            options.input = parse_input(value);
+        }
+        else if (name == "--seed")
+        {
+            options.seed = parse_seed(value, name);
+        }
+        else if (name == "--verify")
+        {
+            options.verify = parse_verify(value);
+        }
+        else if (name == "--meta-json")
+        {
+            options.meta_json = value;
+        }
+        else if (name == "--threads")
+        {
+            options.threads = parse_int(value, name, 0, 4096);
+        }
+        else if (name == "--schedule")
+        {
+            options.schedule = parse_schedule(value);
+        }
+        else if (name == "--sched-stats")
+        {
+            options.sched_stats = value;
+        }
+        else if (name == "--perf-stats")
+        {
+            options.perf_stats = value;
+        }
+        else if (name == "--roofline")
+        {
+            options.roofline = value;
+        }
+        else if (name == "--samples")
+        {
+            options.samples = value;
+        }
+        else if (name == "--ci-target")
+        {
+            options.ci_target = parse_double(value, name, 0.0, 1.0);
+        }
+        else if (name == "--time-cap")
+        {
+            options.time_cap = parse_double(value, name, 0.0, 1e6);
+        }
+        else if (name == "--max-threads")
+        {
+            options.max_threads = parse_int(value, name, 1, 4096);
+        }
+        else if (name == "--sparse")
+        {
+            options.sparse = parse_densities(value, name);
+        }
+        else if (name == "--mat1")
+        {
+            options.mat1 = value;
+        }
+        else if (name == "--mat2")
+        {
+            options.mat2 = value;
+        }
+        else if (name == "--res-out")
+        {
+            options.res_out = value;
+        }
+        else if (name == "--ooc")
+        {
+            options.ooc_dir = value;
+        }
+        else if (name == "--ooc-mem")
+        {
+            options.ooc_mem = parse_int(value, name, 1, 1 << 20);
+        }
+        else if (name == "--sweep")
+        {
+            options.sweep_kernels = parse_list(value, name, parse_kernel);
+        }
+        else if (name == "--sweep-dtypes")
+        {
+            options.sweep_dtypes = parse_list(value, name, parse_dtype);
+        }
+        else if (name == "--results-json")
+        {
+            options.results_json = value;
+        }
+        else if (name == "--init")
+        {
+            options.init = parse_init(value);
+        }
+        else if (name == "--pin")
+        {
+            options.pin = parse_pin(value, options.pin_cpus);
+        }
+        else if (name == "--distributed")
+        {
+            options.distributed = parse_int(value, name, 1, 1024);
+        }
+        else if (name == "--dist-algorithm")
+        {
+            options.dist_algorithm = parse_dist_algorithm(value);
+        }
+        else if (name == "--gemm")
+        {
+            options.gemm_shapes = parse_list(value, name, parse_shape);
+        }
+        else if (name == "--trans")
+        {
+            options.gemm_trans = parse_list(value, name, parse_gemm_trans);
+        }
+        else if (name == "--alpha")
+        {
+            options.alpha = parse_double(value, name, -1e6, 1e6);
+        }
+        else if (name == "--beta")
+        {
+            options.beta = parse_double(value, name, -1e6, 1e6);
+        }
+        else if (name == "--ld-pad")
+        {
+            options.ld_pad = parse_int(value, name, 0, 4096);
+        }
+        else if (name == "--shape-ratio")
+        {
+            options.shape_ratio = parse_int(value, name, 1, 100000);
+        }
+        else if (name == "--tune-cache")
+        {
+            options.tune_cache = value;
+        }
+        else if (name == "--batch")
+        {
+            options.batch = parse_int(value, name, 1, 100000000);
+        }
+        else if (name == "--strassen-cutoff")
+        {
+            options.strassen_cutoff = parse_int(value, name, 1, 100000);
+        }
+        else if (name == "--tile-i")
+        {
+            options.tile_i = parse_int(value, name, 1, 100000);
+        }
+        else if (name == "--tile-j")
+        {
+            options.tile_j = parse_int(value, name, 1, 100000);
+        }
+        else if (name == "--tile-k")
+        {
+            options.tile_k = parse_int(value, name, 1, 100000);
+        }
+        else
+        {
+            throw std::invalid_argument("Opcao desconhecida: " + name);
+        }
+    }
+
+    return options;
 }
 
 int main(int argc, char **argv)
 {
-    if (argc != 6)
+    if (argc < 6)
     {
-        std::cerr << "Uso: " << argv[0] << " <B> <Npts> <M> <Escala> <out_csv>\n";
-        std::cerr << "Exemplo: " << argv[0] << " 4000 12 5 1 out/execucao/resultado_cpp.csv\n";
+        std::cerr << "Uso: " << argv[0] << " <B> <Npts> <M> <Escala> <out_csv> [opcoes]\n";
+        std::cerr << "Opcoes: --kernel naive|blocked|simd|strassen|blas|morton|packed\n"
+                  << "        --dtype int32|int64|float|double\n"
+                  << "        --isa auto|scalar|sse4.1|avx2|avx512 --alloc vector|arena|hugepage\n"
+                  << "        --input identity|random --seed <n> --verify sample|freivalds\n"
+                  << "        --tile-i <n> --tile-j <n> --tile-k <n> --strassen-cutoff <n>\n"
+                  << "        --threads <T> --threads-sweep\n"
+                  << "        --max-threads <T> --schedule static|steal --sched-stats <csv>\n"
+                  << "        --init serial|parallel --pin none|compact|scatter|<lista de CPUs>\n"
+                  << "        --perf-stats <csv> --mem-stats --samples <csv> --ci-target <fracao> --time-cap <s>\n"
+                  << "        --roofline <json>\n"
+                  << "        --sparse <densidades>\n"
+                  << "        --sweep <kernels> --sweep-dtypes <tipos> --results-json <arquivo>\n"
+                  << "        --gemm <formas> --trans nn|nt|tn|tt --alpha <a> --beta <b> --ld-pad <p>\n"
+                  << "        --shape-ratio <r>\n"
+                  << "        --mat1 <arquivo> --mat2 <arquivo> --res-out <arquivo>\n"
+                  << "        --ooc <dir> --ooc-mem <MiB>\n"
+                  << "        --distributed <P> --dist-algorithm summa|cannon\n"
+                  << "        --tune --tune-cache <json> --no-tune-cache\n"
+                  << "        --batch <quantidade> --meta-json <arquivo>\n";
+        std::cerr << "Exemplo: " << argv[0] << " 4000 12 5 1 out/execucao/resultado_cpp.csv --kernel blocked\n";
         return 1;
     }
 
@@ -189,6 +684,284 @@ int main(int argc, char **argv)
         const int m_count = parse_int(argv[3], "M", 1, 100000);
         const int escala = parse_int(argv[4], "Escala", 0, 1);
         const std::string out_csv = argv[5];
+        Options options = parse_options(argc, argv, 6);
+        std::vector<int> points = make_points(b, npts, escala);
+        if (!options.sparse.empty())
+        {
+            if (options.batch > 0 || options.threads_sweep || options.tune || !options.ooc_dir.empty() ||
+                !options.mat1.empty())
+            {
+                throw std::invalid_argument("--sparse nao combina com --batch, --threads-sweep, --tune, --ooc ou "
+                                            "--mat1");
+            }
+            if (!options.sched_stats.empty() || !options.perf_stats.empty() || !options.samples.empty() ||
+                !options.roofline.empty())
+            {
+                throw std::invalid_argument("--sparse grava as medias no proprio CSV; nao combina com --sched-stats, "
+                                            "--perf-stats, --samples ou --roofline");
+            }
+        }
+        if (!options.mat1.empty() || !options.mat2.empty() || !options.res_out.empty())
+        {
+#ifndef MATRIZ_MMAP
+            throw std::invalid_argument("--mat1/--mat2/--res-out exigem Linux (arquivos mapeados com mmap)");
+#endif
+            if (options.mat1.empty() || options.mat2.empty())
+            {
+                throw std::invalid_argument("--mat1 e --mat2 devem ser passados juntos (--res-out exige os dois)");
+            }
+            if (!options.ooc_dir.empty() || options.batch > 0 || options.tune || options.given.count("--input") != 0)
+            {
+                throw std::invalid_argument("--mat1/--mat2 nao combinam com --ooc, --batch, --tune ou --input");
+            }
+            const MatrixFileHeader header1 = read_matrix_header(options.mat1);
+            const MatrixFileHeader header2 = read_matrix_header(options.mat2);
+            if (header1.rows != header1.cols || header2.rows != header1.rows || header2.cols != header1.cols ||
+                header2.dtype != header1.dtype || header1.rows > 100000)
+            {
+                throw std::invalid_argument("--mat1 e --mat2 devem ser quadradas, do mesmo N (ate 100000) e tipo");
+            }
+            const DType file_dtype = static_cast<DType>(header1.dtype);
+            if (options.given.count("--dtype") != 0 && options.dtype != file_dtype)
+            {
+                throw std::invalid_argument(std::string("--dtype difere do tipo dos arquivos: ") +
+                                            dtype_name(file_dtype));
+            }
+            options.dtype = file_dtype;
+            if (options.verify == Verify::Sample && options.given.count("--verify") != 0)
+            {
+                throw std::invalid_argument("--verify sample so confere --input identity; use --verify freivalds");
+            }
+            options.verify = Verify::Freivalds;
+            points.assign(1, static_cast<int>(header1.rows));
+            std::cout << "Matrizes " << header1.rows << "x" << header1.cols << " (" << dtype_name(file_dtype)
+                      << ") lidas de arquivo"
+                      << (header1.stride == header1.cols && header2.stride == header2.cols
+                              ? " sem copia (mmap).\n"
+                              : "; stride != cols, carga compactada em memoria.\n");
+        }
+        if (options.input == Input::Random && options.given.count("--verify") == 0)
+        {
+            options.verify = Verify::Freivalds;
+        }
+        if (options.input == Input::Random && options.verify == Verify::Sample)
+        {
+            throw std::invalid_argument("--verify sample so confere --input identity; use --verify freivalds");
+        }
+        if (options.batch > 0 && (!options.perf_stats.empty() || !options.samples.empty()))
+        {
+            throw std::invalid_argument("--batch grava as medias no proprio CSV; nao combina com --perf-stats ou "
+                                        "--samples");
+        }
+        if (!options.ooc_dir.empty())
+        {
+#ifndef MATRIZ_MMAP
+            throw std::invalid_argument("--ooc exige Linux (arquivos mapeados com mmap)");
+#endif
+            if (options.given.count("--kernel") != 0 || options.given.count("--threads") != 0 ||
+                options.batch > 0 || options.threads_sweep || options.tune)
+            {
+                throw std::invalid_argument("--ooc usa kernel proprio em uma thread; nao combina com --kernel, "
+                                            "--threads, --batch, --threads-sweep ou --tune");
+            }
+        }
+        if (!options.sweep_kernels.empty())
+        {
+            if (options.given.count("--kernel") != 0 || options.batch > 0 || options.threads_sweep || options.tune ||
+                !options.sparse.empty() || !options.ooc_dir.empty() || !options.mat1.empty() ||
+                options.distributed > 0)
+            {
+                throw std::invalid_argument("--sweep nao combina com --kernel, --batch, --threads-sweep, --tune, "
+                                            "--sparse, --ooc, --mat1 ou --distributed");
+            }
+            if (!options.sched_stats.empty() || !options.perf_stats.empty() || !options.samples.empty() ||
+                !options.roofline.empty())
+            {
+                throw std::invalid_argument("--sweep grava as amostras em --results-json; nao combina com "
+                                            "--sched-stats, --perf-stats, --samples ou --roofline");
+            }
+            if (options.sweep_dtypes.empty())
+            {
+                options.sweep_dtypes.push_back(options.dtype);
+            }
+            for (Kernel kernel : options.sweep_kernels)
+            {
+                for (DType dtype : options.sweep_dtypes)
+                {
+                    check_blas(kernel, dtype);
+                }
+            }
+        }
+        else if (!options.sweep_dtypes.empty() || !options.results_json.empty())
+        {
+            throw std::invalid_argument("--sweep-dtypes e --results-json exigem --sweep");
+        }
+        if (options.mem_stats)
+        {
+#ifndef MATRIZ_RUSAGE
+            throw std::invalid_argument("--mem-stats exige Linux (getrusage e /proc/self)");
+#endif
+            if (options.batch > 0 || !options.sparse.empty() || options.distributed > 0 ||
+                !options.sweep_kernels.empty() || !options.gemm_shapes.empty() || options.tune ||
+                options.threads_sweep)
+            {
+                throw std::invalid_argument("--mem-stats grava colunas no CSV padrao; nao combina com --batch, "
+                                            "--sparse, --distributed, --sweep, --gemm, --tune ou --threads-sweep");
+            }
+        }
+        if (!options.roofline.empty() && (options.batch > 0 || options.threads_sweep || !options.sparse.empty() ||
+                                          options.distributed > 0 || options.tune))
+        {
+            throw std::invalid_argument("--roofline grava colunas no CSV padrao; nao combina com --batch, "
+                                        "--threads-sweep, --sparse, --distributed ou --tune");
+        }
+        if (!options.gemm_shapes.empty())
+        {
+            if (options.given.count("--kernel") != 0 || options.batch > 0 || options.threads_sweep || options.tune ||
+                !options.sparse.empty() || !options.ooc_dir.empty() || !options.mat1.empty() ||
+                options.distributed > 0 || !options.sweep_kernels.empty())
+            {
+                throw std::invalid_argument("--gemm usa o kernel GEMM geral; nao combina com --kernel, --batch, "
+                                            "--threads-sweep, --tune, --sparse, --ooc, --mat1, --distributed ou "
+                                            "--sweep");
+            }
+            if (!options.sched_stats.empty() || !options.perf_stats.empty() || !options.samples.empty() ||
+                !options.roofline.empty() || options.given.count("--input") != 0 ||
+                options.given.count("--verify") != 0)
+            {
+                throw std::invalid_argument("--gemm usa entradas aleatorias conferidas com Freivalds; nao combina "
+                                            "com --sched-stats, --perf-stats, --samples, --roofline, --input ou "
+                                            "--verify");
+            }
+            // Com entradas em [-8, 8] e K <= 100000, |C| <= 100 * 64 * K + 100 * 8
+            // cabe em int32; escalares maiores transbordariam.
+            if ((options.dtype == DType::Int32 || options.dtype == DType::Int64) &&
+                (options.alpha != std::round(options.alpha) || options.beta != std::round(options.beta) ||
+                 std::fabs(options.alpha) > 100.0 || std::fabs(options.beta) > 100.0))
+            {
+                throw std::invalid_argument("--alpha e --beta devem ser inteiros entre -100 e 100 com --dtype int32 "
+                                            "ou int64");
+            }
+            if (options.gemm_trans.empty())
+            {
+                options.gemm_trans.push_back(GemmTrans::NN);
+            }
+        }
+        else if (!options.gemm_trans.empty() || options.given.count("--alpha") != 0 ||
+                 options.given.count("--beta") != 0 || options.given.count("--ld-pad") != 0 ||
+                 options.given.count("--shape-ratio") != 0)
+        {
+            throw std::invalid_argument("--trans, --alpha, --beta, --ld-pad e --shape-ratio exigem --gemm");
+        }
+        if (options.distributed > 0)
+        {
+#ifndef MATRIZ_MMAP
+            throw std::invalid_argument("--distributed exige Linux (fork e memoria compartilhada)");
+#endif
+            const int side = static_cast<int>(std::lround(std::sqrt(static_cast<double>(options.distributed))));
+            if (side * side != options.distributed)
+            {
+                throw std::invalid_argument("--distributed exige um quadrado perfeito de processos (1, 4, 9, 16, ...)");
+            }
+            if (options.given.count("--kernel") != 0 || options.given.count("--threads") != 0 ||
+                options.batch > 0 || options.threads_sweep || options.tune || !options.sparse.empty() ||
+                !options.ooc_dir.empty() || !options.mat1.empty())
+            {
+                throw std::invalid_argument("--distributed usa kernel proprio em uma thread por processo; nao combina "
+                                            "com --kernel, --threads, --batch, --threads-sweep, --tune, --sparse, "
+                                            "--ooc ou --mat1");
+            }
+            if (!options.sched_stats.empty() || !options.perf_stats.empty() || !options.samples.empty() ||
+                !options.roofline.empty())
+            {
+                throw std::invalid_argument("--distributed grava as medias no proprio CSV; nao combina com "
+                                            "--sched-stats, --perf-stats, --samples ou --roofline");
+            }
+        }
+        const Isa detected = detect_isa();
+        options.isa = resolve_isa(options.isa, detected);
+        if (uses_isa(options.kernel) && options.dtype == DType::Int64 && options.isa != Isa::Scalar)
+        {
+            std::cout << "Sem micro-kernel SIMD para int64; usando o micro-kernel escalar.\n";
+            options.isa = Isa::Scalar;
+        }
+        const int logical_cpus = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        if (options.max_threads == 0)
+        {
+            options.max_threads = logical_cpus;
+        }
+        if (options.threads == 0)
+        {
+            options.threads = logical_cpus;
+        }
+        if (options.pin != Pin::None)
+        {
+#ifndef MATRIZ_AFFINITY
+            throw std::invalid_argument("--pin exige Linux (sched_setaffinity)");
+#endif
+            options.pin_cpus = pin_layout(options);
+            pin_thread(options, 0);
+            std::cout << "Afinidade " << pin_name(options.pin) << ": CPUs das threads 0, 1, ... (ciclicas) ["
+                      << json_int_list(options.pin_cpus) << "].\n";
+        }
+        check_blas(options.kernel, options.dtype);
+        if (options.kernel == Kernel::Blas && (!options.sched_stats.empty() || options.tune))
+        {
+            throw std::invalid_argument("--kernel blas usa as threads e os blocos da propria biblioteca; nao combina "
+                                        "com --sched-stats ou --tune");
+        }
+#ifdef MATRIZ_BLAS
+        if (options.kernel == Kernel::Blas ||
+            std::count(options.sweep_kernels.begin(), options.sweep_kernels.end(), Kernel::Blas) != 0)
+        {
+            std::cout << "Kernel blas com " << blas_library() << ".\n";
+        }
+#endif
+        if (uses_isa(options.kernel))
+        {
+            std::cout << "Kernel " << kernel_name(options.kernel) << " com ISA " << isa_name(options.isa)
+                      << " (CPU suporta ate " << isa_name(detected) << ").\n";
+        }
+        if (options.kernel == Kernel::Packed)
+        {
+            print_packed_blocking(options);
+        }
+        if (options.tune && (options.tune_cache.empty() || options.batch > 0 || options.threads_sweep))
+        {
+            throw std::invalid_argument("--tune exige --tune-cache e nao combina com --batch ou --threads-sweep");
+        }
+        if (options.tune && options.kernel == Kernel::Packed)
+        {
+            throw std::invalid_argument("--tune nao ajusta o kernel packed: MC/KC/NC vem dos caches da CPU ou de "
+                                        "--tile-i/--tile-k/--tile-j");
+        }
+        if (options.tune && !has_tune_axes(options, points.front()))
+        {
+            throw std::invalid_argument(std::string("--tune sem parametros a buscar para o kernel ") +
+                                        kernel_name(options.kernel) +
+                                        " (todos fixados, ou --threads/--schedule sem --max-threads)");
+        }
+        const std::string cpu = cpu_model();
+        std::vector<TuneEntry> tuning;
+        if (!options.tune && options.batch == 0 && options.gemm_shapes.empty())
+        {
+            for (const TuneEntry &entry : load_tune_cache(options.tune_cache))
+            {
+                if (same_target(entry, cpu, options))
+                {
+                    tuning.push_back(entry);
+                }
+            }
+            if (!tuning.empty())
+            {
+                std::cout << "Usando " << tuning.size() << " faixa(s) de N do cache do autotuner "
+                          << options.tune_cache << " (" << cpu << ").\n";
+            }
+        }
+        if (!options.tune && !options.meta_json.empty() && !write_meta_json(options, detected, cpu, tuning))
+        {
+            return 1;
+        }
 
         std::ofstream file(out_csv);
         if (!file.is_open())
@@ -197,39 +970,132 @@ int main(int argc, char **argv)
             return 1;
         }
 
-        file << "N,TCS,TAM,TDM\n";
         file << std::scientific << std::setprecision(6);
 
-        for (int n : make_points(b, npts, escala))
+        std::ofstream stats_file;
+        if (!options.sched_stats.empty())
         {
-            double warm_alloc = 0.0;
-            double warm_calc = 0.0;
-            double warm_free = 0.0;
-            double time_alloc = 0.0;
-            double time_calc = 0.0;
-            double time_free = 0.0;
+            stats_file.open(options.sched_stats);
+            if (!stats_file.is_open())
+            {
+                std::cerr << "Erro ao abrir arquivo de saida: " << options.sched_stats << "\n";
+                return 1;
+            }
+            stats_file << "N,THREADS,THREAD,TAREFAS,ROUBOS,OCUPADO,OCIOSO\n";
+            stats_file << std::scientific << std::setprecision(6);
+        }
+        std::ofstream *stats_out = stats_file.is_open() ? &stats_file : nullptr;
 
-            if (!run_once(n, warm_alloc, warm_calc, warm_free))
+        std::ofstream perf_file;
+        if (!options.perf_stats.empty())
+        {
+            perf_file.open(options.perf_stats);
+            if (!perf_file.is_open())
             {
+                std::cerr << "Erro ao abrir arquivo de saida: " << options.perf_stats << "\n";
                 return 1;
             }
+            perf_file << "N,THREADS,CICLOS,INSTRUCOES,IPC,L1D_FALHAS,LLC_FALHAS,DTLB_FALHAS\n";
+            perf_file << std::scientific << std::setprecision(6);
+            open_perf_counters();
+        }
+        std::ofstream *perf_out = perf_file.is_open() ? &perf_file : nullptr;
 
-            for (int m = 0; m < m_count; m++)
+        std::ofstream samples_file;
+        if (!options.samples.empty())
+        {
+            samples_file.open(options.samples);
+            if (!samples_file.is_open())
             {
-                if (!run_once(n, time_alloc, time_calc, time_free))
-                {
-                    return 1;
-                }
+                std::cerr << "Erro ao abrir arquivo de saida: " << options.samples << "\n";
+                return 1;
+            }
+            samples_file << "N,THREADS,REP,TCS,TAM,TDM\n";
+            samples_file << std::scientific << std::setprecision(6);
+        }
+        std::ofstream *samples_out = samples_file.is_open() ? &samples_file : nullptr;
+
+        if (options.batch > 0)
+        {
+            if (!run_batch(options, m_count, file))
+            {
+                return 1;
+            }
+            std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
+            return 0;
+        }
+
+        if (!options.sparse.empty())
+        {
+            if (!run_sparse(points, options, m_count, file))
+            {
+                return 1;
+            }
+            std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
+            return 0;
+        }
+
+#ifdef MATRIZ_MMAP
+        if (options.distributed > 0)
+        {
+            if (!run_distributed(points, options, m_count, file))
+            {
+                return 1;
+            }
+            std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
+            return 0;
+        }
+#endif
+
+        if (!options.sweep_kernels.empty())
+        {
+            if (!run_sweep(points, options, m_count, file, cpu))
+            {
+                return 1;
+            }
+            std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
+            return 0;
+        }
+
+        if (!options.gemm_shapes.empty())
+        {
+            if (!run_gemm(points, options, m_count, file))
+            {
+                return 1;
             }
+            std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
+            return 0;
+        }
 
-            file << n << ","
-                 << (time_calc / static_cast<double>(m_count)) << ","
-                 << (time_alloc / static_cast<double>(m_count)) << ","
-                 << (time_free / static_cast<double>(m_count)) << "\n";
+        if (options.tune)
+        {
+            if (!run_tune(points, options, m_count, file, cpu, tuning))
+            {
+                return 1;
+            }
+            if (!options.meta_json.empty() && !write_meta_json(options, detected, cpu, tuning))
+            {
+                return 1;
+            }
+            std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
+            return 0;
+        }
 
-            std::cout << "Resultados para N = " << n << " salvos.\n";
+        if (options.threads_sweep)
+        {
+            if (!run_threads_sweep(points, options, tuning, m_count, file, stats_out, perf_out,
+                                   samples_out))
+            {
+                return 1;
+            }
+            std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
+            return 0;
         }
 
+        if (!run_standard(points, options, tuning, m_count, detected, file, stats_out, perf_out, samples_out))
+        {
+            return 1;
+        }
         std::cout << "Todos os resultados foram salvos em " << out_csv << ".\n";
     }
     catch (const std::exception &ex)
@@ -3,6 +3,7 @@ from __future__ import annotations
 
 import argparse
 import csv
+import json
 import os
 import sys
 from pathlib import Path
@@ -57,10 +58,103 @@ FILES = {
     "C_O3": out_dir / "resultado_c_O3.csv",
     "C++": out_dir / "resultado_cpp.csv",
     "C++_O3": out_dir / "resultado_cpp_O3.csv",
+    "C++_blocked_O3": out_dir / "resultado_cpp_blocked_O3.csv",
+    "C++_simd_O3": out_dir / "resultado_cpp_simd_O3.csv",
+    "C++_steal_O3": out_dir / "resultado_cpp_steal_O3.csv",
+    "C++_strassen_O3": out_dir / "resultado_cpp_strassen_O3.csv",
+    "C++_morton_O3": out_dir / "resultado_cpp_morton_O3.csv",
+    "C++_packed_O3": out_dir / "resultado_cpp_packed_O3.csv",
+    "C++_simd_random_O3": out_dir / "resultado_cpp_simd_random_O3.csv",
+    "C++_ooc_O3": out_dir / "resultado_cpp_ooc_O3.csv",
+    "C++_simd_int64_O3": out_dir / "resultado_cpp_simd_int64_O3.csv",
+    "C++_simd_float_O3": out_dir / "resultado_cpp_simd_float_O3.csv",
+    "C++_simd_double_O3": out_dir / "resultado_cpp_simd_double_O3.csv",
+    "C++_arena_O3": out_dir / "resultado_cpp_arena_O3.csv",
+    "C++_hugepage_O3": out_dir / "resultado_cpp_hugepage_O3.csv",
+    "C++_blas_O3": out_dir / "resultado_cpp_blas_O3.csv",
     "Java": out_dir / "resultado_java.csv",
     "Python": out_dir / "resultado_python.csv",
 }
 
+# Variantes de kernel do C++ ficam fora dos graficos por linguagem.
+KERNEL_VARIANTS = {
+    "C++_blocked_O3",
+    "C++_simd_O3",
+    "C++_simd_random_O3",
+    "C++_steal_O3",
+    "C++_strassen_O3",
+    "C++_morton_O3",
+    "C++_packed_O3",
+    "C++_ooc_O3",
+}
+# Kernel simd com outros tipos de elemento (--dtype), na ordem do grafico.
+DTYPE_VARIANTS = ["C++_simd_O3", "C++_simd_int64_O3", "C++_simd_float_O3", "C++_simd_double_O3"]
+# Politicas de alocacao (--alloc), comparadas com o vector padrao de C++_O3.
+ALLOC_VARIANTS = ["C++_O3", "C++_arena_O3", "C++_hugepage_O3"]
+# Kernel blas (OpenBLAS/BLIS) contra o melhor kernel proprio no mesmo tipo (double).
+BLAS_VARIANTS = ["C++_simd_double_O3", "C++_blas_O3"]
+CPP_VARIANTS = KERNEL_VARIANTS | set(DTYPE_VARIANTS) | set(ALLOC_VARIANTS[1:]) | set(BLAS_VARIANTS)
+
+# Escalonamento forte por kernel: sufixo dos graficos -> (CSV, rotulo do titulo).
+SCALING_CSVS = {
+    "": (out_dir / "resultado_cpp_scaling_O3.csv", "C++ -O3"),
+    "_blas": (out_dir / "resultado_cpp_blas_scaling_O3.csv", "kernel blas"),
+}
+BATCH_CSV = out_dir / "resultado_cpp_batch_O3.csv"
+OOC_CSV = out_dir / "resultado_cpp_ooc_O3.csv"
+# Kernels que separam parte do custo em uma coluna propria: kernel -> (CSV,
+# coluna, rotulo da coluna, kernel de referencia, titulo, grafico).
+PHASE_PLOTS = {
+    "morton": (
+        out_dir / "resultado_cpp_morton_O3.csv",
+        "T_CONVERSAO",
+        "conversoes de layout",
+        "blocked",
+        "Layout Morton cache-oblivious",
+        "grafico_morton_conversao.png",
+    ),
+    "packed": (
+        out_dir / "resultado_cpp_packed_O3.csv",
+        "T_EMPACOTAMENTO",
+        "empacotamento",
+        "simd",
+        "Paineis empacotados (GotoBLAS)",
+        "grafico_packed_empacotamento.png",
+    ),
+}
+SPARSE_CSV = out_dir / "resultado_cpp_sparse_O3.csv"
+SWEEP_JSON = out_dir / "resultado_cpp_sweep_O3.json"
+GEMM_CSV = out_dir / "resultado_cpp_gemm_O3.csv"
+DISTRIBUTED_CSVS = {
+    "SUMMA": out_dir / "resultado_cpp_summa_O3.csv",
+    "Cannon": out_dir / "resultado_cpp_cannon_O3.csv",
+}
+PERF_CSVS = {
+    "C++_O3": out_dir / "resultado_cpp_O3_perf.csv",
+    "C++_blocked_O3": out_dir / "resultado_cpp_blocked_O3_perf.csv",
+}
+SAMPLES_CSVS = {
+    "cpp_O3": out_dir / "resultado_cpp_O3_amostras.csv",
+    "cpp_blocked_O3": out_dir / "resultado_cpp_blocked_O3_amostras.csv",
+}
+ROOFLINE_JSONS = {
+    "C++_O3": out_dir / "resultado_cpp_O3.roofline.json",
+    "C++_blocked_O3": out_dir / "resultado_cpp_blocked_O3.roofline.json",
+    "C++_simd_O3": out_dir / "resultado_cpp_simd_O3.roofline.json",
+}
+PERF_METRICS = {
+    "IPC": ("Instrucoes por ciclo", "grafico_contadores_ipc.png"),
+    "L1D_FALHAS": ("Falhas de leitura em L1D por multiplicacao", "grafico_contadores_l1d.png"),
+    "LLC_FALHAS": ("Falhas de leitura em LLC por multiplicacao", "grafico_contadores_llc.png"),
+    "DTLB_FALHAS": ("Falhas de leitura em dTLB por multiplicacao", "grafico_contadores_dtlb.png"),
+}
+# Colunas de --mem-stats: fase -> rotulo na legenda.
+MEM_PHASES = {"TAM": "alocacao", "TCS": "calculo", "TDM": "liberacao"}
+THREAD_STATS = {
+    "estatico": out_dir / "resultado_cpp_scaling_O3_threads.csv",
+    "roubo": out_dir / "resultado_cpp_steal_O3_threads.csv",
+}
+
 METRICS = ["TCS", "TAM", "TDM"]
 TITLES = {
     "TCS": "Tempo de Calculo da Multiplicacao",
@@ -104,6 +198,34 @@ def read_csv(path: Path) -> list[dict[str, float]]:
     return sorted(rows, key=lambda item: item["N"])
 
 
+def read_rows(
+    path: Path, columns: list[str] | None = None, text: tuple[str, ...] = (), optional: bool = False
+) -> list[dict]:
+    """Linhas dos CSVs auxiliares: columns (todas, se None) convertidas para float e text mantidas como texto.
+
+    Sem alguma das colunas pedidas o CSV e ignorado (com aviso, a nao ser que optional); linhas invalidas
+    sao avisadas e ignoradas.
+    """
+    rows: list[dict] = []
+    with path.open(newline="", encoding="utf-8-sig") as file:
+        reader = csv.DictReader(file)
+        fieldnames = reader.fieldnames or []
+        missing = [col for col in (columns or []) + list(text) if col not in fieldnames]
+        if missing:
+            if not optional:
+                print(f"Aviso: {path} ignorado; colunas ausentes: {', '.join(missing)}")
+            return rows
+        for line_number, row in enumerate(reader, start=2):
+            try:
+                values: dict = {key: float(row[key]) for key in (columns if columns is not None else fieldnames)}
+            except (TypeError, ValueError):
+                print(f"Aviso: linha invalida ignorada em {path}:{line_number}")
+                continue
+            values.update({key: row[key] for key in text})
+            rows.append(values)
+    return rows
+
+
 def load_data() -> dict[str, list[dict[str, float]]]:
     excluded = {normalize_label(label) for label in ARGS.exclude}
     known_labels = set(FILES)
@@ -167,13 +289,513 @@ def plot_series(metric: str, series: list[tuple[str, list[dict[str, float]]]], o
     print(f"{metric}: salvo em {output_path}")
 
 
+def read_scaling_csv(path: Path) -> dict[int, list[tuple[int, float, float]]]:
+    series: dict[int, list[tuple[int, float, float]]] = {}
+    for row in read_rows(path, ["N", "THREADS", "SPEEDUP", "EFICIENCIA"]):
+        series.setdefault(int(row["N"]), []).append((int(row["THREADS"]), row["SPEEDUP"], row["EFICIENCIA"]))
+    return {n: sorted(points) for n, points in series.items()}
+
+
+def plot_scaling() -> None:
+    for suffix, (path, title) in SCALING_CSVS.items():
+        if path.exists():
+            plot_scaling_csv(path, suffix, title)
+
+
+def plot_scaling_csv(path: Path, suffix: str, title: str) -> None:
+    series = read_scaling_csv(path)
+    if not series:
+        print(f"Aviso: nenhuma linha valida em {path}")
+        return
+
+    max_threads = max(point[0] for points in series.values() for point in points)
+    for column, ylabel, output_name, ideal in (
+        (1, "Speedup (TCS(1) / TCS(T))", f"grafico_escalonamento{suffix}_speedup.png", lambda t: t),
+        (2, "Eficiencia paralela (speedup / T)", f"grafico_escalonamento{suffix}_eficiencia.png", lambda t: 1.0),
+    ):
+        plt.figure()
+        for n, points in series.items():
+            plt.plot([p[0] for p in points], [p[column] for p in points], marker="o", label=f"N={n}")
+        ideal_x = sorted({p[0] for points in series.values() for p in points})
+        plt.plot(ideal_x, [ideal(t) for t in ideal_x], linestyle="--", color="gray", label="ideal")
+        plt.xlabel("Threads")
+        plt.ylabel(ylabel)
+        plt.title(f"Escalonamento forte {title} (ate {max_threads} threads)")
+        plt.xscale("log", base=2)
+        plt.grid(True, alpha=0.3)
+        plt.legend()
+        output_path = out_dir / output_name
+        plt.savefig(output_path, dpi=160, bbox_inches="tight")
+        plt.close()
+        print(f"Escalonamento: salvo em {output_path}")
+
+
+def plot_batch() -> None:
+    """Kernel especializado (N constexpr) vs generico no modo lote."""
+    if not BATCH_CSV.exists():
+        return
+    rows = read_rows(BATCH_CSV)
+    if not rows:
+        return
+
+    rows.sort(key=lambda row: row["N"])
+    xs = [row["N"] for row in rows]
+    for prefix, ylabel, output_name in (
+        ("GFLOPS", "GFLOP/s", "grafico_lote_gflops.png"),
+        ("MATS_S", "Matrizes por segundo", "grafico_lote_matrizes.png"),
+    ):
+        plt.figure()
+        plt.plot(xs, [row[f"{prefix}_ESPECIALIZADO"] for row in rows], marker="o", label="especializado (N constexpr)")
+        plt.plot(xs, [row[f"{prefix}_GENERICO"] for row in rows], marker="o", label="generico (N em execucao)")
+        plt.xticks(xs)
+        plt.xlabel("N (matriz com NxN elementos)")
+        plt.ylabel(ylabel)
+        if prefix == "MATS_S":
+            plt.yscale("log")
+        plt.title(f"Lote de {int(rows[0]['LOTE'])} matrizes pequenas - C++ -O3")
+        plt.grid(True, alpha=0.3)
+        plt.legend()
+        output_path = out_dir / output_name
+        plt.savefig(output_path, dpi=160, bbox_inches="tight")
+        plt.close()
+        print(f"Lote: salvo em {output_path}")
+
+
+def plot_ooc() -> None:
+    """Motor fora do nucleo: tempo total, E/S, calculo e espera pela leitura por N."""
+    if not OOC_CSV.exists():
+        return
+    rows = read_rows(OOC_CSV, ["N", "TCS", "T_IO", "T_COMPUTO", "T_ESPERA"])
+    if not rows:
+        return
+
+    rows.sort(key=lambda row: row["N"])
+    xs = [row["N"] for row in rows]
+    plt.figure()
+    for key, label in (
+        ("TCS", "total (TCS)"),
+        ("T_COMPUTO", "calculo"),
+        ("T_IO", "E/S (leitura + escrita)"),
+        ("T_ESPERA", "espera pela leitura"),
+    ):
+        plt.plot(xs, [max(row[key], 1e-9) for row in rows], marker="o", label=label)
+    plt.xlabel("N (matriz com NxN elementos)")
+    plt.ylabel("Tempo (s)")
+    plt.yscale("log")
+    plt.title("Multiplicacao fora do nucleo - C++ -O3")
+    plt.grid(True, alpha=0.3)
+    plt.legend()
+    output_path = out_dir / "grafico_ooc_tempos.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Fora do nucleo: salvo em {output_path}")
+
+
+def plot_phases() -> None:
+    """Produto (TCS) e a parte do custo em coluna propria (PHASE_PLOTS) por N, com o kernel de referencia."""
+    for kernel, (path, column, column_label, reference, title, output_name) in PHASE_PLOTS.items():
+        if not path.exists():
+            continue
+        rows = sorted(read_rows(path, ["N", "TCS", column]), key=lambda row: row["N"])
+        if not rows:
+            continue
+
+        xs = [row["N"] for row in rows]
+        plt.figure()
+        plt.plot(xs, [row["TCS"] for row in rows], marker="o", label=f"{kernel}: produto (TCS)")
+        plt.plot(xs, [max(row[column], 1e-9) for row in rows], marker="o", label=f"{kernel}: {column_label}")
+        reference_path = FILES[f"C++_{reference}_O3"]
+        if reference_path.exists():
+            reference_rows = sorted(read_csv(reference_path), key=lambda row: row["N"])
+            plt.plot(
+                [row["N"] for row in reference_rows],
+                [row["TCS"] for row in reference_rows],
+                marker="o",
+                linestyle="--",
+                label=f"{reference} (TCS)",
+            )
+        plt.xlabel("N (matriz com NxN elementos)")
+        plt.ylabel("Tempo (s)")
+        plt.yscale("log")
+        plt.title(f"{title} - C++ -O3")
+        plt.grid(True, alpha=0.3)
+        plt.legend()
+        output_path = out_dir / output_name
+        plt.savefig(output_path, dpi=160, bbox_inches="tight")
+        plt.close()
+        print(f"{kernel.capitalize()}: salvo em {output_path}")
+
+
+def plot_sparse() -> None:
+    """Ganho de SpMM/SpGEMM sobre o kernel denso e memoria do CSR por densidade, uma curva por N."""
+    if not SPARSE_CSV.exists():
+        return
+    by_n: dict[int, list[dict[str, float]]] = {}
+    for values in read_rows(SPARSE_CSV):
+        by_n.setdefault(int(values["N"]), []).append(values)
+    if not by_n:
+        return
+
+    plt.figure()
+    for n in sorted(by_n):
+        rows = sorted(by_n[n], key=lambda row: row["DENSIDADE"])
+        xs = [row["DENSIDADE"] for row in rows]
+        (line,) = plt.plot(xs, [row["GANHO_SPMM"] for row in rows], marker="o", label=f"SpMM N={n}")
+        plt.plot(xs, [row["GANHO_SPGEMM"] for row in rows], marker="s", linestyle="--", color=line.get_color(),
+                 label=f"SpGEMM N={n}")
+    plt.axhline(1.0, color="black", linewidth=1, linestyle=":", label="empate com o denso")
+    plt.xscale("log")
+    plt.yscale("log")
+    plt.xlabel("Densidade de mat1 (fracao de nao nulos)")
+    plt.ylabel("Ganho sobre o kernel denso (T_DENSO / T)")
+    plt.title("CSR vs denso - C++ -O3")
+    plt.grid(True, which="both", alpha=0.3)
+    plt.legend(fontsize="small")
+    output_path = out_dir / "grafico_esparso_ganho.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Esparso: salvo em {output_path}")
+
+    plt.figure()
+    for n in sorted(by_n):
+        rows = sorted(by_n[n], key=lambda row: row["DENSIDADE"])
+        plt.plot([row["DENSIDADE"] for row in rows], [row["BYTES_CSR"] / row["BYTES_DENSO"] for row in rows],
+                 marker="o", label=f"N={n}")
+    plt.axhline(1.0, color="black", linewidth=1, linestyle=":", label="mesma memoria do denso")
+    plt.xscale("log")
+    plt.yscale("log")
+    plt.xlabel("Densidade de mat1 (fracao de nao nulos)")
+    plt.ylabel("Bytes do CSR / bytes da matriz densa")
+    plt.title("Memoria do CSR - C++ -O3")
+    plt.grid(True, which="both", alpha=0.3)
+    plt.legend()
+    output_path = out_dir / "grafico_esparso_memoria.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Esparso: salvo em {output_path}")
+
+
+def plot_sweep() -> None:
+    """Varredura intercalada de kernels: mediana do TCS com o IC de 95% e GOP/s por N, uma curva por kernel/dtype."""
+    if not SWEEP_JSON.exists():
+        return
+    try:
+        results = json.loads(SWEEP_JSON.read_text(encoding="utf-8-sig"))["results"]
+    except (json.JSONDecodeError, KeyError) as exc:
+        print(f"Aviso: {SWEEP_JSON} ignorado: {exc}")
+        return
+    series: dict[str, list[dict]] = {}
+    for result in results:
+        series.setdefault(f"{result['kernel']} ({result['dtype']})", []).append(result)
+    if not series:
+        return
+
+    plt.figure()
+    for label, rows in series.items():
+        rows.sort(key=lambda row: row["n"])
+        medians = [row["tcs"]["median"] for row in rows]
+        # O limite inferior do IC pode ficar negativo; no eixo log ele e cortado no TCS minimo.
+        lower = [max(0.0, med - max(row["tcs"]["ci95_low"], row["tcs"]["min"])) for med, row in zip(medians, rows)]
+        upper = [max(0.0, row["tcs"]["ci95_high"] - med) for med, row in zip(medians, rows)]
+        plt.errorbar([row["n"] for row in rows], medians, yerr=[lower, upper], marker="o", capsize=3, label=label)
+    plt.xlabel("N (matriz com NxN elementos)")
+    plt.ylabel("TCS mediano (s), barras: IC de 95%")
+    plt.yscale("log")
+    plt.title("Kernels intercalados no mesmo processo - C++ -O3")
+    plt.grid(True, alpha=0.3)
+    plt.legend(fontsize="small")
+    output_path = out_dir / "grafico_varredura_tcs.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Varredura: salvo em {output_path}")
+
+    plt.figure()
+    for label, rows in series.items():
+        plt.plot([row["n"] for row in rows], [row["gops"] for row in rows], marker="o", label=label)
+    plt.xlabel("N (matriz com NxN elementos)")
+    plt.ylabel("GOP/s (2 N^3 / TCS)")
+    plt.title("Vazao dos kernels intercalados - C++ -O3")
+    plt.grid(True, alpha=0.3)
+    plt.legend(fontsize="small")
+    output_path = out_dir / "grafico_varredura_gops.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Varredura: salvo em {output_path}")
+
+
+def plot_gemm() -> None:
+    """GEMM geral: GOP/s por N, um painel por forma e uma curva por transposicao."""
+    if not GEMM_CSV.exists():
+        return
+    by_shape: dict[str, dict[str, list[tuple[int, float]]]] = {}
+    dims: dict[str, str] = {}
+    for row in read_rows(GEMM_CSV, ["N", "GOPS", "DIM_M", "DIM_N", "DIM_K"], text=("FORMA", "TRANS")):
+        by_shape.setdefault(row["FORMA"], {}).setdefault(row["TRANS"], []).append((int(row["N"]), row["GOPS"]))
+        dims[row["FORMA"]] = f"{row['DIM_M']:.0f}x{row['DIM_N']:.0f}x{row['DIM_K']:.0f}"
+    if not by_shape:
+        return
+
+    fig, axes = plt.subplots(1, len(by_shape), figsize=(4 * len(by_shape), 4), sharey=True, squeeze=False)
+    for ax, (shape, series) in zip(axes[0], by_shape.items()):
+        for trans, points in series.items():
+            points.sort()
+            ax.plot([n for n, _ in points], [gops for _, gops in points], marker="o", label=trans)
+        ax.set_title(f"{shape} (MxNxK no maior N: {dims[shape]})", fontsize="small")
+        ax.set_xlabel("N (ponto da varredura)")
+        ax.grid(True, alpha=0.3)
+        ax.legend(fontsize="small", title="op(A) op(B)")
+    axes[0][0].set_ylabel("GOP/s (2 M N K / TCS)")
+    fig.suptitle("GEMM geral por forma e transposicao - C++ -O3")
+    output_path = out_dir / "grafico_gemm_formas.png"
+    fig.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close(fig)
+    print(f"GEMM: salvo em {output_path}")
+
+
+def plot_distributed() -> None:
+    """SUMMA e Cannon: calculo, comunicacao e sincronizacao (medias entre processos) e bytes movidos por N."""
+    series: dict[str, dict[int, list[dict[str, float]]]] = {}
+    for label, path in DISTRIBUTED_CSVS.items():
+        if not path.exists():
+            continue
+        for values in read_rows(path):
+            series.setdefault(label, {}).setdefault(int(values["N"]), []).append(values)
+    if not series:
+        return
+
+    def mean(rows: list[dict[str, float]], key: str) -> float:
+        return sum(row[key] for row in rows) / len(rows)
+
+    plt.figure()
+    for (label, by_n), marker in zip(series.items(), ("o", "s")):
+        ns = sorted(by_n)
+        for key, name, style in (
+            ("T_COMPUTO", "calculo", "-"),
+            ("T_COMUNICACAO", "comunicacao", "--"),
+            ("T_SINCRONIZACAO", "sincronizacao", ":"),
+        ):
+            plt.plot(ns, [max(mean(by_n[n], key), 1e-9) for n in ns], marker=marker, linestyle=style,
+                     label=f"{label} {name}")
+    plt.xlabel("N (matriz com NxN elementos)")
+    plt.ylabel("Tempo medio por processo (s)")
+    plt.yscale("log")
+    plt.title("Multiplicacao distribuida (processos em grade 2-D) - C++ -O3")
+    plt.grid(True, alpha=0.3)
+    plt.legend(fontsize="small")
+    output_path = out_dir / "grafico_distribuido_tempos.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Distribuido: salvo em {output_path}")
+
+    plt.figure()
+    for (label, by_n), marker in zip(series.items(), ("o", "s")):
+        ns = sorted(by_n)
+        plt.plot(ns, [sum(row["BYTES"] for row in by_n[n]) / 2**20 for n in ns], marker=marker, label=label)
+    plt.xlabel("N (matriz com NxN elementos)")
+    plt.ylabel("MiB movidos (soma dos processos)")
+    plt.title("Comunicacao por memoria compartilhada - C++ -O3")
+    plt.grid(True, alpha=0.3)
+    plt.legend()
+    output_path = out_dir / "grafico_distribuido_bytes.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Distribuido: salvo em {output_path}")
+
+
+def plot_memory() -> None:
+    """Pico de RSS e faltas de pagina menores por fase nos CSVs gravados com --mem-stats."""
+    series: dict[str, list[dict[str, float]]] = {}
+    for label, path in FILES.items():
+        if not path.exists():
+            continue
+        columns = ["N"] + [f"{prefix}_{phase}" for phase in MEM_PHASES for prefix in ("RSS_PICO", "FALTAS_MENORES")]
+        rows = read_rows(path, columns, optional=True)
+        if rows:
+            series[label] = sorted(rows, key=lambda row: row["N"])
+    if not series:
+        return
+
+    for prefix, ylabel, scale, output_name in (
+        ("RSS_PICO", "Pico de RSS (MiB)", 1.0 / (1024 * 1024), "grafico_memoria_rss.png"),
+        ("FALTAS_MENORES", "Faltas de pagina menores por repeticao", 1.0, "grafico_memoria_faltas.png"),
+    ):
+        plt.figure()
+        for label, rows in series.items():
+            xs = [row["N"] for row in rows]
+            for (phase, phase_label), style in zip(MEM_PHASES.items(), ("-", "--", ":")):
+                # Faltas na liberacao sao quase sempre zero; ficam so no CSV.
+                if prefix == "FALTAS_MENORES" and phase == "TDM":
+                    continue
+                plt.plot(
+                    xs,
+                    [row[f"{prefix}_{phase}"] * scale for row in rows],
+                    marker="o",
+                    linestyle=style,
+                    label=f"{label} ({phase_label})",
+                )
+        plt.xlabel("N (matriz com NxN elementos)")
+        plt.ylabel(ylabel)
+        plt.yscale("symlog" if prefix == "FALTAS_MENORES" else "linear")
+        plt.title(f"Memoria por fase C++ -O3 - {ylabel}")
+        plt.grid(True, alpha=0.3)
+        plt.legend(fontsize=8)
+        output_path = out_dir / output_name
+        plt.savefig(output_path, dpi=160, bbox_inches="tight")
+        plt.close()
+        print(f"Memoria: salvo em {output_path}")
+
+
+def plot_perf_counters() -> None:
+    """Contadores de hardware por N; colunas N/A (contador indisponivel) sao ignoradas."""
+    series: dict[str, list[dict[str, str]]] = {}
+    for label, path in PERF_CSVS.items():
+        if path.exists():
+            with path.open(newline="", encoding="utf-8-sig") as file:
+                series[label] = list(csv.DictReader(file))
+
+    for column, (ylabel, output_name) in PERF_METRICS.items():
+        plt.figure()
+        plotted = False
+        for label, rows in series.items():
+            points = []
+            for row in rows:
+                try:
+                    points.append((float(row["N"]), float(row[column])))
+                except (KeyError, TypeError, ValueError):
+                    continue
+            if points:
+                points.sort()
+                plt.plot([p[0] for p in points], [p[1] for p in points], marker="o", label=label)
+                plotted = True
+        if not plotted:
+            plt.close()
+            continue
+
+        plt.xlabel("N (matriz com NxN elementos)")
+        plt.ylabel(ylabel)
+        if column != "IPC":
+            plt.yscale("log")
+        plt.title(f"Contadores de hardware C++ -O3 - {column}")
+        plt.grid(True, alpha=0.3)
+        plt.legend()
+        output_path = out_dir / output_name
+        plt.savefig(output_path, dpi=160, bbox_inches="tight")
+        plt.close()
+        print(f"Contadores: salvo em {output_path}")
+
+
+def plot_samples() -> None:
+    """Boxplot do TCS por N a partir dos tempos de cada repeticao (--samples)."""
+    for name, path in SAMPLES_CSVS.items():
+        if not path.exists():
+            continue
+        by_n: dict[int, list[float]] = {}
+        for row in read_rows(path, ["N", "TCS"]):
+            by_n.setdefault(int(row["N"]), []).append(row["TCS"])
+        if not by_n:
+            continue
+
+        ns = sorted(by_n)
+        plt.figure(figsize=(max(6.4, 0.6 * len(ns)), 4.8))
+        positions = list(range(1, len(ns) + 1))
+        plt.boxplot([by_n[n] for n in ns], positions=positions, showfliers=True)
+        plt.xticks(positions, [str(n) for n in ns])
+        plt.xlabel("N (matriz com NxN elementos)")
+        plt.ylabel("Tempo (s)")
+        plt.yscale("log")
+        plt.title(f"Distribuicao do TCS por repeticao - {name.replace('cpp', 'C++').replace('_O3', ' -O3')}")
+        plt.grid(True, axis="y", alpha=0.3)
+        output_path = out_dir / f"grafico_TCS_boxplot_{name}.png"
+        plt.savefig(output_path, dpi=160, bbox_inches="tight")
+        plt.close()
+        print(f"Amostras: salvo em {output_path}")
+
+
+def plot_roofline() -> None:
+    """Pontos (intensidade, GOP/s) de cada kernel sob os tetos de banda e de computacao."""
+    runs: dict[str, dict] = {}
+    for label, path in ROOFLINE_JSONS.items():
+        if path.exists():
+            try:
+                runs[label] = json.loads(path.read_text(encoding="utf-8"))
+            except json.JSONDecodeError as exc:
+                print(f"Aviso: {path} ignorado; JSON invalido: {exc}")
+    runs = {label: run for label, run in runs.items() if run.get("points")}
+    if not runs:
+        return
+
+    plt.figure()
+    intensities = [point["intensity"] for run in runs.values() for point in run["points"]]
+    low = min(intensities + [run["ridge_intensity"] for run in runs.values()]) / 4
+    high = max(intensities) * 4
+    xs = [low * (high / low) ** (step / 200) for step in range(201)]
+    # Cada execucao mede os tetos de novo; usa os da primeira (naive) para nao sobrepor linhas quase iguais.
+    reference = next(iter(runs.values()))
+    bandwidth, peak = reference["bandwidth_gbs"], reference["peak_gops"]
+    plt.plot(
+        xs,
+        [min(peak, x * bandwidth) for x in xs],
+        linestyle="--",
+        color="gray",
+        label=f"teto: {bandwidth:.1f} GB/s, {peak:.1f} GOP/s",
+    )
+    for label, run in runs.items():
+        points = sorted(run["points"], key=lambda point: point["n"])
+        plt.plot([p["intensity"] for p in points], [p["gops"] for p in points], marker="o", label=label)
+
+    plt.xscale("log")
+    plt.yscale("log")
+    plt.xlabel("Intensidade aritmetica minima (op/byte)")
+    plt.ylabel("GOP/s")
+    plt.title("Roofline C++ -O3")
+    plt.grid(True, which="both", alpha=0.3)
+    plt.legend(fontsize=8)
+    output_path = out_dir / "grafico_roofline.png"
+    plt.savefig(output_path, dpi=160, bbox_inches="tight")
+    plt.close()
+    print(f"Roofline: salvo em {output_path}")
+
+
+def plot_thread_stats() -> None:
+    """Tempo ocupado/ocioso por thread no maior N e no maior numero de threads."""
+    for name, path in THREAD_STATS.items():
+        if not path.exists():
+            continue
+        rows = read_rows(path, ["N", "THREADS", "THREAD", "ROUBOS", "OCUPADO", "OCIOSO"])
+        if not rows:
+            continue
+
+        n = max(row["N"] for row in rows)
+        threads = max(row["THREADS"] for row in rows if row["N"] == n)
+        selected = sorted((row for row in rows if row["N"] == n and row["THREADS"] == threads), key=lambda r: r["THREAD"])
+        ids = [int(row["THREAD"]) for row in selected]
+        busy = [row["OCUPADO"] for row in selected]
+        idle = [row["OCIOSO"] for row in selected]
+
+        plt.figure()
+        plt.bar(ids, busy, label="ocupado")
+        plt.bar(ids, idle, bottom=busy, label="ocioso")
+        for thread_id, total, row in zip(ids, (b + i for b, i in zip(busy, idle)), selected):
+            plt.annotate(f"{row['ROUBOS']:.0f} roubos", (thread_id, total), ha="center", va="bottom", fontsize=7)
+        plt.xticks(ids)
+        plt.xlabel("Thread")
+        plt.ylabel("Tempo medio por repeticao (s)")
+        plt.title(f"Carga por thread ({name}) - N={int(n)}, {int(threads)} threads")
+        plt.grid(True, axis="y", alpha=0.3)
+        plt.legend()
+        output_path = out_dir / f"grafico_threads_{name}.png"
+        plt.savefig(output_path, dpi=160, bbox_inches="tight")
+        plt.close()
+        print(f"Carga por thread: salvo em {output_path}")
+
+
 def main() -> int:
     data = load_data()
 
     for metric in METRICS:
         plot_series(
             metric,
-            [(label, rows) for label, rows in data.items()],
+            [(label, rows) for label, rows in data.items() if label not in CPP_VARIANTS],
             f"grafico_{metric}_todas_linguagens.png",
             f"Comparacao por linguagem - {TITLES[metric]}",
         )
@@ -211,7 +833,49 @@ def main() -> int:
         )
 
     for metric in METRICS:
-        subset = [(label, rows) for label, rows in data.items() if label != "Python"]
+        subset = [(label, data[label]) for label in ("C++_O3", *sorted(KERNEL_VARIANTS)) if label in data]
+        if len(subset) > 1:
+            plot_series(
+                metric,
+                subset,
+                f"grafico_{metric}_CPP_kernels.png",
+                f"Kernels C++ -O3 - {TITLES[metric]}",
+            )
+
+    for metric in METRICS:
+        subset = [(label, data[label]) for label in DTYPE_VARIANTS if label in data]
+        if len(subset) > 1:
+            plot_series(
+                metric,
+                subset,
+                f"grafico_{metric}_CPP_dtypes.png",
+                f"Kernel simd C++ -O3 por tipo - {TITLES[metric]}",
+            )
+
+    for metric in METRICS:
+        subset = [(label, data[label]) for label in ALLOC_VARIANTS if label in data]
+        if len(subset) > 1:
+            plot_series(
+                metric,
+                subset,
+                f"grafico_{metric}_CPP_alocacao.png",
+                f"Politicas de alocacao C++ -O3 - {TITLES[metric]}",
+            )
+
+    for metric in METRICS:
+        subset = [(label, data[label]) for label in BLAS_VARIANTS if label in data]
+        if len(subset) > 1:
+            plot_series(
+                metric,
+                subset,
+                f"grafico_{metric}_CPP_blas.png",
+                f"Kernel simd vs BLAS (double) C++ -O3 - {TITLES[metric]}",
+            )
+
+    for metric in METRICS:
+        subset = [
+            (label, rows) for label, rows in data.items() if label != "Python" and label not in CPP_VARIANTS
+        ]
         plot_series(
             metric,
             subset,
@@ -219,6 +883,20 @@ def main() -> int:
             f"Todas as linguagens exceto Python - {TITLES[metric]}",
         )
 
+    plot_scaling()
+    plot_thread_stats()
+    plot_batch()
+    plot_ooc()
+    plot_phases()
+    plot_sparse()
+    plot_distributed()
+    plot_sweep()
+    plot_gemm()
+    plot_perf_counters()
+    plot_memory()
+    plot_samples()
+    plot_roofline()
+
     print(f"Concluido. Graficos em: {out_dir}")
     return 0
 